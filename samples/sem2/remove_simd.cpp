@@ -0,0 +1,344 @@
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define REMOVE_SIMD_X86
+#include <immintrin.h>
+#endif
+
+// my_remove and my_remove_if from remove.cpp move the kept elements one by one and branch on
+// every element, which mispredicts when removed elements are scattered. For arrays of trivially
+// copyable types the overloads below compact without branches: every element is written to
+// the output position and the position moves only if it is kept. Arrays of 4 and 8 byte
+// numbers are compacted a whole vector at a time with AVX-512 or AVX2, chosen at runtime.
+// As with std::remove, elements after the returned end are left in an unspecified state.
+
+template <class ForwardIt, class T>
+ForwardIt my_remove(ForwardIt first, ForwardIt last, const T& value) {
+    first = std::find(first, last, value);
+    if (first != last) {
+        for (ForwardIt i = first; ++i != last;) {
+            if (!(*i == value)) {
+                *first++ = std::move(*i);
+            }
+        }
+    }
+    return first;
+}
+
+template <class ForwardIt, class UnaryPredicate>
+ForwardIt my_remove_if(ForwardIt first, ForwardIt last, UnaryPredicate p) {
+    first = std::find_if(first, last, p);
+    if (first != last) {
+        for (ForwardIt i = first; ++i != last;) {
+            if (!p(*i)) {
+                *first++ = std::move(*i);
+            }
+        }
+    }
+    return first;
+}
+
+template <class It>
+concept TrivialContiguous =
+    std::contiguous_iterator<It> && std::is_trivially_copyable_v<std::iter_value_t<It>> &&
+    std::is_assignable_v<std::iter_reference_t<It>, std::iter_value_t<It>>;
+
+namespace detail {
+
+// Numbers whose vector comparison gives the same answer as ==
+template <class T>
+concept SimdNumber = (std::integral<T> || std::floating_point<T>) && (sizeof(T) == 4 || sizeof(T) == 8);
+
+// Compacts data[from, size) to data[out, ...), out <= from, returns the new end.
+// data[out] is overwritten by every element: it was already read, or it is the element itself.
+template <class T, class Remove>
+std::size_t CompactScalar(T* data, std::size_t from, std::size_t size, std::size_t out, Remove remove) {
+    for (std::size_t i = from; i < size; ++i) {
+        const T x = data[i];
+        data[out] = x;
+        out += !remove(x);
+    }
+    return out;
+}
+
+// Elements before the first removed one stay in place, they are skipped with a plain search
+template <class T, class Remove>
+std::size_t CompactRemaining(T* data, std::size_t size, Remove remove) {
+    const std::size_t first = std::find_if(data, data + size, remove) - data;
+    return CompactScalar(data, first, size, first, remove);
+}
+
+#ifdef REMOVE_SIMD_X86
+
+// Lane indices for _mm256_permutevar8x32_epi32 that gather the kept lanes of a mask to the
+// front: 8 lanes of 32 bits, or 4 lanes of 64 bits as pairs of 32 bit lanes
+template <std::size_t lanes>
+constexpr auto MakeCompressTable() {
+    constexpr std::size_t halves = 8 / lanes;
+    std::array<std::array<std::uint32_t, 8>, 1 << lanes> table{};
+    for (std::size_t mask = 0; mask < table.size(); ++mask) {
+        std::size_t out = 0;
+        for (std::size_t lane = 0; lane < lanes; ++lane) {
+            if (mask >> lane & 1) {
+                for (std::size_t half = 0; half < halves; ++half) {
+                    table[mask][out * halves + half] = lane * halves + half;
+                }
+                ++out;
+            }
+        }
+    }
+    return table;
+}
+
+alignas(32) inline constexpr auto compressTable32 = MakeCompressTable<8>();
+alignas(32) inline constexpr auto compressTable64 = MakeCompressTable<4>();
+
+// The compacted vector is stored whole at data + out: the lanes past the kept ones land on
+// elements of the current vector or earlier, which are already loaded, and are overwritten later.
+// Vectors are loaded before any store to their range, so no kept element is lost.
+
+template <class T>
+__attribute__((target("avx2,popcnt"))) std::size_t RemoveAvx2(T* data, std::size_t size, T value) {
+    constexpr std::size_t width = 32 / sizeof(T);
+    std::size_t out = 0;
+    std::size_t i = 0;
+    for (; i + width <= size; i += width) {
+        const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        int removed;
+        if constexpr (std::same_as<T, float>) {
+            removed = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_castsi256_ps(x), _mm256_set1_ps(value), _CMP_EQ_OQ));
+        } else if constexpr (std::same_as<T, double>) {
+            removed = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_castsi256_pd(x), _mm256_set1_pd(value), _CMP_EQ_OQ));
+        } else if constexpr (sizeof(T) == 4) {
+            const __m256i equal = _mm256_cmpeq_epi32(x, _mm256_set1_epi32(static_cast<std::int32_t>(value)));
+            removed = _mm256_movemask_ps(_mm256_castsi256_ps(equal));
+        } else {
+            const __m256i equal = _mm256_cmpeq_epi64(x, _mm256_set1_epi64x(static_cast<std::int64_t>(value)));
+            removed = _mm256_movemask_pd(_mm256_castsi256_pd(equal));
+        }
+        const unsigned kept = ~removed & ((1u << width) - 1);
+        const auto& lanes = sizeof(T) == 4 ? compressTable32[kept] : compressTable64[kept];
+        const __m256i permutation = _mm256_load_si256(reinterpret_cast<const __m256i*>(lanes.data()));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(data + out), _mm256_permutevar8x32_epi32(x, permutation));
+        out += __builtin_popcount(kept);
+    }
+    return CompactScalar(data, i, size, out, [value](T x) { return x == value; });
+}
+
+template <class T>
+__attribute__((target("avx512f,popcnt"))) std::size_t RemoveAvx512(T* data, std::size_t size, T value) {
+    constexpr std::size_t width = 64 / sizeof(T);
+    std::size_t out = 0;
+    std::size_t i = 0;
+    for (; i + width <= size; i += width) {
+        const __m512i x = _mm512_loadu_si512(data + i);
+        __m512i compressed;
+        unsigned kept;
+        if constexpr (sizeof(T) == 4) {
+            // Not equal, unordered: a NaN is kept, as !(NaN == value) is true
+            const __mmask16 mask = std::same_as<T, float>
+                ? _mm512_cmp_ps_mask(_mm512_castsi512_ps(x), _mm512_set1_ps(value), _CMP_NEQ_UQ)
+                : _mm512_cmpneq_epi32_mask(x, _mm512_set1_epi32(static_cast<std::int32_t>(value)));
+            compressed = _mm512_maskz_compress_epi32(mask, x);
+            kept = mask;
+        } else {
+            const __mmask8 mask = std::same_as<T, double>
+                ? _mm512_cmp_pd_mask(_mm512_castsi512_pd(x), _mm512_set1_pd(value), _CMP_NEQ_UQ)
+                : _mm512_cmpneq_epi64_mask(x, _mm512_set1_epi64(static_cast<std::int64_t>(value)));
+            compressed = _mm512_maskz_compress_epi64(mask, x);
+            kept = mask;
+        }
+        _mm512_storeu_si512(data + out, compressed);
+        out += __builtin_popcount(kept);
+    }
+    return CompactScalar(data, i, size, out, [value](T x) { return x == value; });
+}
+
+#endif // REMOVE_SIMD_X86
+
+enum class Isa { Scalar, Avx2, Avx512 };
+
+inline Isa BestIsa() {
+#ifdef REMOVE_SIMD_X86
+    static const Isa isa = __builtin_cpu_supports("avx512f") ? Isa::Avx512
+                         : __builtin_cpu_supports("avx2")    ? Isa::Avx2
+                                                             : Isa::Scalar;
+    return isa;
+#else
+    return Isa::Scalar;
+#endif
+}
+
+// New size of data[0, size) without the elements equal to 'value'
+template <class T>
+std::size_t RemoveValue(T* data, std::size_t size, const T& value, Isa isa = BestIsa()) {
+    if constexpr (SimdNumber<T>) {
+#ifdef REMOVE_SIMD_X86
+        if (isa == Isa::Avx512) {
+            return RemoveAvx512(data, size, value);
+        }
+        if (isa == Isa::Avx2) {
+            return RemoveAvx2(data, size, value);
+        }
+#endif
+    }
+    return CompactRemaining(data, size, [&value](const T& x) { return x == value; });
+}
+
+// The vector paths compare elements with 'value' converted to the element type. That agrees
+// with x == value only if the conversion loses nothing: removing 3.5 from ints removes nothing,
+// and 'a' + 256 is not 'a'. A float is never converted to an integer, that may be undefined.
+template <class Value, class T>
+bool ConvertsExactly(const T& value) {
+    if constexpr (std::same_as<T, Value>) {
+        return true;
+    } else if constexpr (std::is_arithmetic_v<T> && std::is_arithmetic_v<Value>
+                         && !(std::floating_point<T> && std::integral<Value>)) {
+        return static_cast<T>(static_cast<Value>(value)) == value;
+    } else {
+        return false;
+    }
+}
+
+// Elements equal to 'value' as x == value compares them, through the vector paths when
+// 'value' converts to T exactly
+template <class T, class U>
+std::size_t RemoveEqual(T* data, std::size_t size, const U& value) {
+    if (ConvertsExactly<T>(value)) {
+        return RemoveValue<T>(data, size, static_cast<T>(value));
+    }
+    return CompactRemaining(data, size, [&value](const T& x) { return x == value; });
+}
+
+inline std::size_t Threads(std::size_t threads) {
+    return threads != 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Two passes: the parts are compacted in place by their threads, then the kept prefix of
+// every part is moved down next to the previous one. The second pass moves only kept
+// elements and runs at memcpy speed.
+template <class T, class CompactPart>
+std::size_t ParallelCompact(T* data, std::size_t size, std::size_t threads, CompactPart compact) {
+    const std::size_t parts = std::min(Threads(threads), std::max<std::size_t>(size / 4096, 1));
+    std::vector<std::size_t> kept(parts);
+    const auto begin = [&](std::size_t part) { return size / parts * part + std::min(part, size % parts); };
+    {
+        std::vector<std::jthread> workers;
+        for (std::size_t part = 1; part < parts; ++part) {
+            workers.emplace_back([&, part] { kept[part] = compact(data + begin(part), begin(part + 1) - begin(part)); });
+        }
+        kept[0] = compact(data, begin(1));
+    }
+    std::size_t out = kept[0];
+    for (std::size_t part = 1; part < parts; ++part) {
+        std::memmove(data + out, data + begin(part), kept[part] * sizeof(T));
+        out += kept[part];
+    }
+    return out;
+}
+
+} // namespace detail
+
+template <TrivialContiguous It, class T>
+It my_remove(It first, It last, const T& value) {
+    return first + detail::RemoveEqual(std::to_address(first), last - first, value);
+}
+
+template <TrivialContiguous It, class UnaryPredicate>
+It my_remove_if(It first, It last, UnaryPredicate p) {
+    return first + detail::CompactRemaining(std::to_address(first), last - first, p);
+}
+
+// my_remove and my_remove_if on 'threads' threads, 0 means one per core
+template <TrivialContiguous It, class T>
+It parallel_remove(It first, It last, const T& value, std::size_t threads = 0) {
+    return first + detail::ParallelCompact(std::to_address(first), last - first, threads,
+                                           [&](auto* data, std::size_t size) {
+                                               return detail::RemoveEqual(data, size, value);
+                                           });
+}
+
+template <TrivialContiguous It, class UnaryPredicate>
+It parallel_remove_if(It first, It last, UnaryPredicate p, std::size_t threads = 0) {
+    return first + detail::ParallelCompact(std::to_address(first), last - first, threads,
+                                           [&](auto* data, std::size_t size) {
+                                               return detail::CompactRemaining(data, size, p);
+                                           });
+}
+
+template <class F>
+double Milliseconds(const std::vector<int>& input, std::vector<int>& v, F&& f) {
+    constexpr int iterations = 5;
+    double total = 0;
+    for (int i = 0; i < iterations; ++i) {
+        v = input;
+        const auto start = std::chrono::steady_clock::now();
+        f();
+        total += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    return total / iterations;
+}
+
+int main() {
+    std::vector<int> v{ 1, 2, 3, 4, 5 };
+    v.erase(my_remove(v.begin(), v.end(), 3), v.end());
+    for (auto x : v) {
+        std::cout << x << ' ';
+    }
+    std::cout << std::endl;
+
+    // 16M ints, every element is 0 (removed) with the given probability, at random positions
+    constexpr std::size_t size = 1 << 24;
+    std::mt19937 gen(1);
+    std::vector<int> input(size);
+    std::vector<int> expected;
+    std::cout << "ms for 16M ints\n"
+              << "removed  std::remove   branchless         AVX2      AVX-512     parallel\n";
+    for (const double removed : {0.0, 0.01, 0.1, 0.5, 0.9, 1.0}) {
+        std::bernoulli_distribution zero(removed);
+        for (auto& x : input) {
+            x = zero(gen) ? 0 : static_cast<int>(gen() | 1);
+        }
+        expected = input;
+        expected.erase(std::remove(expected.begin(), expected.end(), 0), expected.end());
+
+        bool correct = true;
+        const auto check = [&](std::size_t newSize) {
+            correct = correct && std::equal(v.begin(), v.begin() + newSize, expected.begin(), expected.end());
+        };
+        std::size_t newSize = 0;
+        std::printf("%6.0f%% %12.2f", removed * 100, Milliseconds(input, v, [&] {
+            newSize = std::remove(v.begin(), v.end(), 0) - v.begin();
+        }));
+        check(newSize);
+        for (const auto isa : {detail::Isa::Scalar, detail::Isa::Avx2, detail::Isa::Avx512}) {
+            if (isa > detail::BestIsa()) {
+                std::printf(" %12s", "-");
+                continue;
+            }
+            std::printf(" %12.2f", Milliseconds(input, v, [&] {
+                newSize = detail::RemoveValue(v.data(), v.size(), 0, isa);
+            }));
+            check(newSize);
+        }
+        std::printf(" %12.2f", Milliseconds(input, v, [&] {
+            newSize = parallel_remove(v.begin(), v.end(), 0) - v.begin();
+        }));
+        check(newSize);
+        std::printf("%s\n", correct ? "" : "  WRONG");
+    }
+}
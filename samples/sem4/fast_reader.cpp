@@ -0,0 +1,291 @@
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+// Reads whitespace separated numbers of type T much faster than in >> value:
+// the file is read with read(2) in large blocks and every token is parsed with std::from_chars,
+// which knows nothing about locales and makes no virtual calls.
+// Unlike operator>> a leading '+' is rejected, as from_chars does.
+class ParseError : public std::runtime_error {
+public:
+    ParseError(const std::string& token, std::size_t offset, std::size_t line)
+        : std::runtime_error("bad number '" + token + "' at line " + std::to_string(line) + ", byte " +
+                             std::to_string(offset))
+        , offset_(offset)
+        , line_(line) { }
+
+    std::size_t offset() const {
+        return offset_;
+    }
+
+    std::size_t line() const {
+        return line_;
+    }
+
+private:
+    std::size_t offset_;
+    std::size_t line_;
+};
+
+template <class T>
+class NumberReader {
+public:
+    class Iterator {
+    public:
+        using iterator_concept = std::input_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+
+        Iterator() = default;
+
+        explicit Iterator(NumberReader* reader) : reader_(reader) {
+            ++*this;
+        }
+
+        const T& operator*() const {
+            return value_;
+        }
+
+        Iterator& operator++() {
+            if (!reader_->next(value_)) {
+                reader_ = nullptr;
+            }
+            return *this;
+        }
+
+        void operator++(int) {
+            ++*this;
+        }
+
+        friend bool operator==(const Iterator& it, std::default_sentinel_t) {
+            return it.reader_ == nullptr;
+        }
+
+    private:
+        NumberReader* reader_ = nullptr;
+        T value_{};
+    };
+
+    // Takes ownership of 'fd'
+    explicit NumberReader(int fd, std::size_t bufferSize = 1 << 20)
+        : fd_(fd), buffer_(std::max<std::size_t>(bufferSize, 1)) { }
+
+    explicit NumberReader(const char* path, std::size_t bufferSize = 1 << 20)
+        : NumberReader(::open(path, O_RDONLY), bufferSize) {
+        if (fd_ < 0) {
+            throw std::system_error(errno, std::generic_category(), path);
+        }
+    }
+
+    NumberReader(const NumberReader&) = delete;
+    NumberReader& operator=(const NumberReader&) = delete;
+
+    ~NumberReader() {
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+
+    // Reads the next number into 'value', false at the end of input.
+    // Throws ParseError for a token that is not entirely a number of type T.
+    bool next(T& value) {
+        while (true) {
+            while (pos_ < end_ && IsSpace(*pos_)) {
+                ++pos_;
+            }
+            if (pos_ == end_) {
+                if (!refill()) {
+                    return false;
+                }
+                continue;
+            }
+            const auto [ptr, ec] = std::from_chars(pos_, end_, value);
+            if (ec == std::errc() && ptr < end_ && IsSpace(*ptr)) {
+                pos_ = ptr;
+                return true;
+            }
+            // The token may continue in the next block: "12" of "123", or "1e" of "1e5"
+            // parses to a prefix or fails, so it is retried once it ends inside the buffer
+            const char* tokenEnd = std::find_if(pos_, end_, IsSpace);
+            if (tokenEnd == end_ && !eof_) {
+                refill();
+                continue;
+            }
+            if (ec != std::errc() || ptr != tokenEnd) {
+                throw error(tokenEnd);
+            }
+            pos_ = ptr;
+            return true;
+        }
+    }
+
+    Iterator begin() {
+        return Iterator(this);
+    }
+
+    std::default_sentinel_t end() const {
+        return {};
+    }
+
+private:
+    int fd_;
+    std::vector<char> buffer_;
+    const char* pos_ = nullptr;
+    const char* end_ = nullptr;
+    bool eof_ = false;
+    // Bytes and lines dropped from the front of the buffer, for error positions
+    std::size_t consumed_ = 0;
+    std::size_t lines_ = 0;
+
+    static bool IsSpace(char c) {
+        return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+    }
+
+    // Moves the unparsed tail to the front and reads after it, growing the buffer if a single
+    // token fills it whole. False if nothing was left and nothing was read.
+    bool refill() {
+        if (eof_) {
+            return false;
+        }
+        char* data = buffer_.data();
+        const std::size_t kept = pos_ ? end_ - pos_ : 0;
+        if (pos_) {
+            consumed_ += pos_ - data;
+            lines_ += std::count(static_cast<const char*>(data), pos_, '\n');
+            std::memmove(data, pos_, kept);
+        }
+        if (kept == buffer_.size()) {
+            buffer_.resize(2 * buffer_.size());
+            data = buffer_.data();
+        }
+        std::size_t filled = kept;
+        while (filled < buffer_.size()) {
+            const ssize_t got = ::read(fd_, data + filled, buffer_.size() - filled);
+            if (got < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::system_error(errno, std::generic_category(), "read");
+            }
+            if (got == 0) {
+                eof_ = true;
+                break;
+            }
+            filled += got;
+        }
+        pos_ = data;
+        end_ = data + filled;
+        return filled != kept || kept != 0;
+    }
+
+    ParseError error(const char* tokenEnd) const {
+        const char* data = buffer_.data();
+        return ParseError(std::string(pos_, std::min<std::size_t>(tokenEnd - pos_, 32)), consumed_ + (pos_ - data),
+                          lines_ + std::count(data, pos_, '\n') + 1);
+    }
+};
+
+template <class T>
+void WriteNumbers(const char* path, std::size_t bytes) {
+    std::ofstream out(path, std::ios::binary);
+    std::vector<char> block(1 << 20);
+    std::size_t written = 0;
+    std::uint64_t state = 1;
+    char* pos = block.data();
+    while (written < bytes) {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        const auto random = static_cast<std::int32_t>(state >> 32);
+        const T value = static_cast<T>(random) / (std::is_floating_point_v<T> ? T(1000) : T(1));
+        pos = std::to_chars(pos, block.data() + block.size(), value).ptr;
+        *pos++ = (state & 0xF) == 0 ? '\n' : ' ';
+        if (block.data() + block.size() - pos < 64) {
+            out.write(block.data(), pos - block.data());
+            written += pos - block.data();
+            pos = block.data();
+        }
+    }
+    out.write(block.data(), pos - block.data());
+}
+
+template <class F>
+void Measure(const char* name, std::size_t bytes, F&& f) {
+    const auto start = std::chrono::steady_clock::now();
+    const auto [count, sum] = f();
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::printf("%-34s %10.1f %12zu %16.6g\n", name, bytes / elapsed.count() / (1 << 20), count,
+                static_cast<double>(sum));
+}
+
+template <class T>
+void Benchmark(const char* type, const char* path, std::size_t bytes) {
+    struct Result {
+        std::size_t count = 0;
+        double sum = 0;
+    };
+    WriteNumbers<T>(path, bytes);
+    std::printf("\n%s, %zu MB\n%-34s %10s %12s %16s\n", type, bytes >> 20, "reader", "MB/s", "numbers", "sum");
+    Measure("std::istream_iterator", bytes, [&] {
+        std::ifstream in(path);
+        Result result;
+        for (auto it = std::istream_iterator<T>(in); it != std::istream_iterator<T>(); ++it) {
+            ++result.count;
+            result.sum += *it;
+        }
+        return result;
+    });
+    // What my_istream_iterator from istream_iterator.cpp does on every ++
+    Measure("in >> value (my_istream_iterator)", bytes, [&] {
+        std::ifstream in(path);
+        Result result;
+        for (T value; in >> value;) {
+            ++result.count;
+            result.sum += value;
+        }
+        return result;
+    });
+    Measure("NumberReader", bytes, [&] {
+        Result result;
+        for (const T value : NumberReader<T>(path)) {
+            ++result.count;
+            result.sum += value;
+        }
+        return result;
+    });
+}
+
+// Usage: fast_reader [megabytes], 256 MB of every type by default
+int main(int argc, char** argv) {
+    const std::size_t bytes = (argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 256) << 20;
+    const char* path = "fast_reader.txt";
+
+    // A tiny buffer makes every other token straddle a block boundary
+    {
+        std::ofstream(path) << "1 -22  333\n4444 1e5\n12x 7";
+        try {
+            for (const double value : NumberReader<double>(path, 4)) {
+                std::cout << value << ' ';
+            }
+        } catch (const ParseError& error) {
+            std::cout << "\n" << error.what() << "\n";
+        }
+    }
+
+    Benchmark<int>("int", path, bytes);
+    Benchmark<float>("float", path, bytes);
+    Benchmark<double>("double", path, bytes);
+    std::remove(path);
+}
@@ -0,0 +1,488 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define MMAP_TOKENIZER_X86
+#include <immintrin.h>
+#endif
+
+// file.cpp reads words with in >> word: every word is copied out of the stream buffer into
+// a std::string. Here the file is mapped into memory and words are string_views into the
+// mapping, found 64 bytes at a time with a whitespace bitmask built by SSE2 or AVX2.
+
+// Read-only mapping of a whole file
+class MappedFile {
+public:
+    explicit MappedFile(const char* path) {
+        const int fd = ::open(path, O_RDONLY);
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), path);
+        }
+        struct stat info;
+        if (::fstat(fd, &info) != 0) {
+            const int error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::generic_category(), path);
+        }
+        size_ = info.st_size;
+        // mmap of zero bytes fails, an empty file is an empty view
+        if (size_ != 0) {
+            void* data = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED) {
+                const int error = errno;
+                ::close(fd);
+                throw std::system_error(error, std::generic_category(), path);
+            }
+            data_ = static_cast<const char*>(data);
+            ::madvise(data, size_, MADV_SEQUENTIAL);
+        }
+        // The mapping stays valid without the descriptor
+        ::close(fd);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+        if (data_) {
+            ::munmap(const_cast<char*>(data_), size_);
+        }
+    }
+
+    std::string_view view() const {
+        return {data_, size_};
+    }
+
+private:
+    const char* data_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+// Whitespace is what isspace accepts in the C locale: ' ' and '\t' '\n' '\v' '\f' '\r'
+inline bool IsSpace(char c) {
+    return c == ' ' || static_cast<unsigned char>(c - '\t') <= '\r' - '\t';
+}
+
+namespace detail {
+
+constexpr std::size_t block = 64;
+
+// Bit i of the mask is set if p[i] is whitespace, for 64 bytes
+
+struct ScalarOps {
+    static std::uint64_t SpaceMask(const char* p) {
+        std::uint64_t mask = 0;
+        for (std::size_t i = 0; i < block; ++i) {
+            mask |= static_cast<std::uint64_t>(IsSpace(p[i])) << i;
+        }
+        return mask;
+    }
+
+    static int Popcount(std::uint64_t x) {
+        return __builtin_popcountll(x);
+    }
+};
+
+#ifdef MMAP_TOKENIZER_X86
+
+struct Sse2Ops {
+    static std::uint64_t SpaceMask(const char* p) {
+        std::uint64_t mask = 0;
+        for (std::size_t i = 0; i < block; i += 16) {
+            const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+            // c - '\t' <= 4 unsigned, as min(c - '\t', 4) == c - '\t'
+            const __m128i shifted = _mm_sub_epi8(x, _mm_set1_epi8('\t'));
+            const __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8('\r' - '\t')), shifted);
+            const __m128i space = _mm_or_si128(control, _mm_cmpeq_epi8(x, _mm_set1_epi8(' ')));
+            mask |= static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm_movemask_epi8(space))) << i;
+        }
+        return mask;
+    }
+
+    static int Popcount(std::uint64_t x) {
+        return __builtin_popcountll(x);
+    }
+};
+
+#define MMAP_TOKENIZER_AVX2 __attribute__((target("avx2,popcnt")))
+
+struct Avx2Ops {
+    MMAP_TOKENIZER_AVX2 static std::uint64_t SpaceMask(const char* p) {
+        std::uint64_t mask = 0;
+        for (std::size_t i = 0; i < block; i += 32) {
+            const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+            const __m256i shifted = _mm256_sub_epi8(x, _mm256_set1_epi8('\t'));
+            const __m256i control =
+                _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, _mm256_set1_epi8('\r' - '\t')), shifted);
+            const __m256i space = _mm256_or_si256(control, _mm256_cmpeq_epi8(x, _mm256_set1_epi8(' ')));
+            mask |= static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm256_movemask_epi8(space))) << i;
+        }
+        return mask;
+    }
+
+    MMAP_TOKENIZER_AVX2 static int Popcount(std::uint64_t x) {
+        return __builtin_popcountll(x);
+    }
+};
+
+inline bool HasAvx2() {
+    static const bool hasAvx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+    return hasAvx2;
+}
+
+#endif // MMAP_TOKENIZER_X86
+
+// The last partial block is copied and padded with spaces, nothing is read past the text
+template <class Ops>
+[[gnu::always_inline]] inline std::uint64_t SpaceMaskAt(std::string_view text, std::size_t offset) {
+    if (offset + block <= text.size()) {
+        return Ops::SpaceMask(text.data() + offset);
+    }
+    char tail[block];
+    std::memset(tail, ' ', block);
+    std::memcpy(tail, text.data() + offset, text.size() - offset);
+    return Ops::SpaceMask(tail);
+}
+
+// A word starts where a non-space follows a space, text.data()[-1] counts as a space
+template <class Ops>
+[[gnu::always_inline]] inline std::size_t CountWordsKernel(std::string_view text) {
+    std::size_t count = 0;
+    std::uint64_t previous = 1;
+    for (std::size_t offset = 0; offset < text.size(); offset += block) {
+        const std::uint64_t space = SpaceMaskAt<Ops>(text, offset);
+        count += Ops::Popcount(~space & (space << 1 | previous));
+        previous = space >> 63;
+    }
+    return count;
+}
+
+inline std::size_t CountWordsScalar(std::string_view text) {
+    return CountWordsKernel<ScalarOps>(text);
+}
+
+#ifdef MMAP_TOKENIZER_X86
+
+inline std::size_t CountWordsSse2(std::string_view text) {
+    return CountWordsKernel<Sse2Ops>(text);
+}
+
+MMAP_TOKENIZER_AVX2 inline std::size_t CountWordsAvx2(std::string_view text) {
+    return CountWordsKernel<Avx2Ops>(text);
+}
+
+inline std::uint64_t SpaceMaskSse2(std::string_view text, std::size_t offset) {
+    return SpaceMaskAt<Sse2Ops>(text, offset);
+}
+
+MMAP_TOKENIZER_AVX2 inline std::uint64_t SpaceMaskAvx2(std::string_view text, std::size_t offset) {
+    return SpaceMaskAt<Avx2Ops>(text, offset);
+}
+
+#undef MMAP_TOKENIZER_AVX2
+
+#endif // MMAP_TOKENIZER_X86
+
+inline std::uint64_t SpaceMaskScalar(std::string_view text, std::size_t offset) {
+    return SpaceMaskAt<ScalarOps>(text, offset);
+}
+
+using SpaceMaskFunction = std::uint64_t (*)(std::string_view, std::size_t);
+
+inline SpaceMaskFunction BestSpaceMask() {
+#ifdef MMAP_TOKENIZER_X86
+    return HasAvx2() ? SpaceMaskAvx2 : SpaceMaskSse2;
+#else
+    return SpaceMaskScalar;
+#endif
+}
+
+} // namespace detail
+
+// Number of whitespace separated words, the same as counting in >> word
+inline std::size_t CountWords(std::string_view text) {
+#ifdef MMAP_TOKENIZER_X86
+    return detail::HasAvx2() ? detail::CountWordsAvx2(text) : detail::CountWordsSse2(text);
+#else
+    return detail::CountWordsScalar(text);
+#endif
+}
+
+// Words of 'text' in order as string_views into it, the text must outlive them
+class Tokenizer {
+public:
+    class Iterator {
+    public:
+        using iterator_concept = std::input_iterator_tag;
+        using value_type = std::string_view;
+        using difference_type = std::ptrdiff_t;
+
+        Iterator() = default;
+
+        explicit Iterator(Tokenizer* tokenizer) : tokenizer_(tokenizer) {
+            ++*this;
+        }
+
+        std::string_view operator*() const {
+            return word_;
+        }
+
+        Iterator& operator++() {
+            if (!tokenizer_->next(word_)) {
+                tokenizer_ = nullptr;
+            }
+            return *this;
+        }
+
+        void operator++(int) {
+            ++*this;
+        }
+
+        friend bool operator==(const Iterator& it, std::default_sentinel_t) {
+            return it.tokenizer_ == nullptr;
+        }
+
+    private:
+        Tokenizer* tokenizer_ = nullptr;
+        std::string_view word_;
+    };
+
+    explicit Tokenizer(std::string_view text, detail::SpaceMaskFunction spaceMask = detail::BestSpaceMask())
+        : text_(text), spaceMask_(spaceMask) { }
+
+    // The next word into 'word', false after the last one
+    bool next(std::string_view& word) {
+        // Find the first non-space bit, then the first space bit after it
+        while (words_ == 0) {
+            if (!load()) {
+                return false;
+            }
+        }
+        const std::size_t start = offset_ + __builtin_ctzll(words_);
+        words_ |= words_ - 1;
+        while (words_ == ~std::uint64_t(0)) {
+            if (!load()) {
+                words_ = 0;
+                word = text_.substr(start);
+                return true;
+            }
+        }
+        const std::size_t end = offset_ + __builtin_ctzll(~words_);
+        // Clears the word's bits: they are the lowest run of ones
+        words_ &= words_ + 1;
+        word = text_.substr(start, end - start);
+        return true;
+    }
+
+    Iterator begin() {
+        return Iterator(this);
+    }
+
+    std::default_sentinel_t end() const {
+        return {};
+    }
+
+private:
+    std::string_view text_;
+    detail::SpaceMaskFunction spaceMask_;
+    // Start of the current block and of the next one
+    std::size_t offset_ = 0;
+    std::size_t next_ = 0;
+    // Non-space bits of the current block not yet returned
+    std::uint64_t words_ = 0;
+
+    bool load() {
+        if (next_ >= text_.size()) {
+            return false;
+        }
+        offset_ = next_;
+        next_ += detail::block;
+        words_ = ~spaceMask_(text_, offset_);
+        if (text_.size() - offset_ < detail::block) {
+            // The padding is not part of the text
+            words_ &= (std::uint64_t(1) << (text_.size() - offset_)) - 1;
+        }
+        return true;
+    }
+};
+
+// 'parts' consecutive pieces of nearly equal size, every cut is moved forward to a whitespace,
+// so no word is split between two pieces
+inline std::vector<std::string_view> SplitAtSpaces(std::string_view text, std::size_t parts) {
+    std::vector<std::string_view> pieces;
+    std::size_t begin = 0;
+    for (std::size_t part = 1; part <= parts; ++part) {
+        std::size_t end = std::max(begin, text.size() / parts * part);
+        if (part == parts) {
+            end = text.size();
+        }
+        while (end < text.size() && !IsSpace(text[end])) {
+            ++end;
+        }
+        pieces.push_back(text.substr(begin, end - begin));
+        begin = end;
+    }
+    return pieces;
+}
+
+inline std::size_t Threads(std::size_t threads) {
+    return threads != 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Calls f(part, word) for every word, parts of the text run on their own threads,
+// words of one part come in order on one thread. 'threads' = 0 means one per core.
+template <class F>
+void ParallelForEachWord(std::string_view text, F f, std::size_t threads = 0) {
+    const auto pieces = SplitAtSpaces(text, Threads(threads));
+    std::vector<std::jthread> workers;
+    for (std::size_t part = 1; part < pieces.size(); ++part) {
+        workers.emplace_back([&, part] {
+            for (const std::string_view word : Tokenizer(pieces[part])) {
+                f(part, word);
+            }
+        });
+    }
+    for (const std::string_view word : Tokenizer(pieces[0])) {
+        f(0, word);
+    }
+}
+
+inline std::size_t ParallelCountWords(std::string_view text, std::size_t threads = 0) {
+    const auto pieces = SplitAtSpaces(text, Threads(threads));
+    std::vector<std::size_t> counts(pieces.size());
+    {
+        std::vector<std::jthread> workers;
+        for (std::size_t part = 1; part < pieces.size(); ++part) {
+            workers.emplace_back([&, part] { counts[part] = CountWords(pieces[part]); });
+        }
+        counts[0] = CountWords(pieces[0]);
+    }
+    std::size_t count = 0;
+    for (const std::size_t part : counts) {
+        count += part;
+    }
+    return count;
+}
+
+// Log-like lines: words from a Zipf-ish vocabulary, tabs and runs of spaces between them
+void WriteText(const char* path, std::size_t bytes) {
+    std::vector<std::string> vocabulary;
+    std::mt19937 gen(1);
+    for (int i = 0; i < 5000; ++i) {
+        std::string word(1 + gen() % 12, 'a');
+        for (auto& c : word) {
+            c = static_cast<char>('a' + gen() % 26);
+        }
+        vocabulary.push_back(word);
+    }
+    std::ofstream out(path, std::ios::binary);
+    std::string line;
+    std::size_t written = 0;
+    while (written < bytes) {
+        line.clear();
+        for (std::size_t words = 4 + gen() % 12; words > 0; --words) {
+            const std::uint32_t r = gen();
+            line += vocabulary[(r % 5000) * (r % 5000) / 5000];
+            line += r % 7 == 0 ? "\t" : r % 5 == 0 ? "   " : " ";
+        }
+        line.back() = '\n';
+        out << line;
+        written += line.size();
+    }
+}
+
+template <class F>
+void Measure(const char* name, std::size_t bytes, F&& f) {
+    const auto start = std::chrono::steady_clock::now();
+    const std::size_t result = f();
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::printf("%-34s %10.1f %12zu\n", name, bytes / elapsed.count() / (1 << 20), result);
+}
+
+// Usage: mmap_tokenizer [megabytes], 256 MB by default
+int main(int argc, char** argv) {
+    const std::size_t bytes = (argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 256) << 20;
+    const char* path = "mmap_tokenizer.txt";
+    WriteText(path, bytes);
+    const MappedFile file(path);
+    const std::string_view text = file.view();
+    // Bring the file into the page cache, so the first reader doesn't pay for the disk
+    std::printf("%zu MB, %zu words\n\n", text.size() >> 20, CountWords(text));
+
+    std::printf("%-34s %10s %12s\n", "word count", "MB/s", "words");
+    Measure("ifstream >> string (file.cpp)", text.size(), [&] {
+        std::ifstream in(path);
+        std::size_t count = 0;
+        for (std::string word; in >> word;) {
+            ++count;
+        }
+        return count;
+    });
+    Measure("Tokenizer, scalar mask", text.size(), [&] {
+        std::size_t count = 0;
+        for (const std::string_view word : Tokenizer(text, detail::SpaceMaskScalar)) {
+            count += !word.empty();
+        }
+        return count;
+    });
+    Measure("Tokenizer", text.size(), [&] {
+        std::size_t count = 0;
+        for (const std::string_view word : Tokenizer(text)) {
+            count += !word.empty();
+        }
+        return count;
+    });
+    Measure("CountWords, scalar", text.size(), [&] { return detail::CountWordsScalar(text); });
+#ifdef MMAP_TOKENIZER_X86
+    Measure("CountWords, SSE2", text.size(), [&] { return detail::CountWordsSse2(text); });
+    if (detail::HasAvx2()) {
+        Measure("CountWords, AVX2", text.size(), [&] { return detail::CountWordsAvx2(text); });
+    }
+#endif
+    for (std::size_t threads = 1; threads <= Threads(0); threads *= 2) {
+        const std::string name = "ParallelCountWords, " + std::to_string(threads) + " threads";
+        Measure(name.c_str(), text.size(), [&] { return ParallelCountWords(text, threads); });
+    }
+
+    // Word frequencies: a string key per word against views into the mapping
+    std::printf("\n%-34s %10s %12s\n", "word frequencies", "MB/s", "distinct");
+    Measure("ifstream >> string, map<string>", text.size(), [&] {
+        std::ifstream in(path);
+        std::unordered_map<std::string, std::size_t> frequencies;
+        for (std::string word; in >> word;) {
+            ++frequencies[word];
+        }
+        return frequencies.size();
+    });
+    Measure("ParallelForEachWord, map<view>", text.size(), [&] {
+        const std::size_t threads = Threads(0);
+        std::vector<std::unordered_map<std::string_view, std::size_t>> frequencies(threads);
+        ParallelForEachWord(
+            text, [&](std::size_t part, std::string_view word) { ++frequencies[part][word]; }, threads);
+        for (std::size_t part = 1; part < threads; ++part) {
+            for (const auto& [word, count] : frequencies[part]) {
+                frequencies[0][word] += count;
+            }
+        }
+        return frequencies[0].size();
+    });
+    std::remove(path);
+}
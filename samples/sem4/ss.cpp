@@ -1,8 +1,20 @@
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <map>
 #include <iomanip>
 #include <iostream>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <system_error>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
 
 std::string FormatMap(const std::map<int, float>& m) {
     std::stringstream ss;
@@ -13,7 +25,160 @@ std::string FormatMap(const std::map<int, float>& m) {
     return ss.str();
 }
 
+// The same text without streams: std::to_chars with chars_format::general and precision 6
+// prints a float exactly as operator<< with setprecision(6) does, both are printf's %.6g.
+// Nothing is allocated once the buffer is large enough.
+
+// The longest entry: an int key "-2147483648", ':', a value like "-1.17549e-38", ';'
+constexpr std::size_t maxEntrySize = 11 + 1 + 12 + 1;
+
+// Writes FormatMap(m) to 'out', which must hold m.size() * maxEntrySize chars,
+// returns the end of the text
+char* FormatMapTo(const std::map<int, float>& m, char* out) {
+    for (const auto& [key, value] : m) {
+        char* const end = out + maxEntrySize;
+        out = std::to_chars(out, end, key).ptr;
+        *out++ = ':';
+        out = std::to_chars(out, end, value, std::chars_format::general, 6).ptr;
+        *out++ = ';';
+    }
+    return out;
+}
+
+// Keeps its buffer between calls, the view is valid until the next call
+class MapFormatter {
+public:
+    std::string_view operator()(const std::map<int, float>& m) {
+        if (buffer_.size() < m.size() * maxEntrySize) {
+            buffer_.resize(m.size() * maxEntrySize);
+        }
+        return {buffer_.data(), static_cast<std::size_t>(FormatMapTo(m, buffer_.data()) - buffer_.data())};
+    }
+
+private:
+    std::vector<char> buffer_;
+};
+
+// Writes maps to a file descriptor one per line, in chunks of 'chunkSize' bytes
+class MapStreamWriter {
+public:
+    explicit MapStreamWriter(int fd, std::size_t chunkSize = 1 << 20) : fd_(fd), buffer_(chunkSize) {
+    }
+
+    MapStreamWriter(const MapStreamWriter&) = delete;
+    MapStreamWriter& operator=(const MapStreamWriter&) = delete;
+
+    // A destructor can't report a failed write, call flush() to see it
+    ~MapStreamWriter() {
+        try {
+            flush();
+        } catch (const std::system_error&) {
+        }
+    }
+
+    void write(const std::map<int, float>& m) {
+        const std::size_t size = m.size() * maxEntrySize + 1;
+        if (buffer_.size() - used_ < size) {
+            flush();
+            if (buffer_.size() < size) {
+                buffer_.resize(size);
+            }
+        }
+        char* end = FormatMapTo(m, buffer_.data() + used_);
+        *end++ = '\n';
+        used_ = end - buffer_.data();
+    }
+
+    void flush() {
+        std::size_t written = 0;
+        while (written < used_) {
+            const ssize_t result = ::write(fd_, buffer_.data() + written, used_ - written);
+            if (result < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                used_ = 0;
+                throw std::system_error(errno, std::generic_category(), "write");
+            }
+            written += result;
+        }
+        used_ = 0;
+    }
+
+private:
+    int fd_;
+    std::vector<char> buffer_;
+    std::size_t used_ = 0;
+};
+
+template <class F>
+double Seconds(F&& f) {
+    const auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
 int main() {
     std::map<int, float> m { {0, 1.12345}, {1, 2.123456}, {2, 3.1234567} };
-    std::cout << FormatMap(m);
+    std::cout << FormatMap(m) << '\n';
+    MapFormatter format;
+    std::cout << format(m) << '\n';
+
+    // Both must print every value the same way, including the extremes
+    constexpr float inf = std::numeric_limits<float>::infinity();
+    std::map<int, float> edge { {INT32_MIN, -std::numeric_limits<float>::min()},
+                                {-1, std::numeric_limits<float>::denorm_min()},
+                                {2, std::numeric_limits<float>::max()}, {3, -inf}, {4, 1e-5f}, {5, 123456.5f},
+                                {6, 1234567.0f}, {7, -0.0f}, {8, std::numeric_limits<float>::quiet_NaN()},
+                                {INT32_MAX, 0.1f} };
+    std::cout << (FormatMap(edge) == format(edge) ? "same" : "different") << ": " << format(edge) << '\n';
+
+    // Many small maps, as in a service serializing a map per record
+    constexpr std::size_t count = 1'000'000;
+    std::mt19937 gen(1);
+    std::uniform_real_distribution<float> value(-1e4, 1e4);
+    std::vector<std::map<int, float>> maps(1000);
+    for (auto& map : maps) {
+        for (int i = 0; i < 8; ++i) {
+            map[gen() % 100000] = value(gen);
+        }
+    }
+    std::size_t mismatches = 0;
+    for (const auto& map : maps) {
+        mismatches += FormatMap(map) != format(map);
+    }
+
+    std::size_t bytes = 0;
+    const double streams = Seconds([&] {
+        for (std::size_t i = 0; i < count; ++i) {
+            bytes += FormatMap(maps[i % maps.size()]).size();
+        }
+    });
+    const double formatter = Seconds([&] {
+        for (std::size_t i = 0; i < count; ++i) {
+            bytes -= format(maps[i % maps.size()]).size();
+        }
+    });
+    const int null = ::open("/dev/null", O_WRONLY);
+    const double ofstream = Seconds([&] {
+        std::ofstream out("/dev/null");
+        for (std::size_t i = 0; i < count; ++i) {
+            out << FormatMap(maps[i % maps.size()]) << '\n';
+        }
+    });
+    const double writer = Seconds([&] {
+        MapStreamWriter out(null);
+        for (std::size_t i = 0; i < count; ++i) {
+            out.write(maps[i % maps.size()]);
+        }
+        out.flush();
+    });
+    ::close(null);
+
+    std::cout << "\n" << mismatches << " mismatches, " << bytes << " bytes differ\n"
+              << "1M maps of 8 entries, ns per map\n"
+              << "FormatMap                 " << streams * 1e9 / count << '\n'
+              << "MapFormatter              " << formatter * 1e9 / count << '\n'
+              << "ofstream << FormatMap     " << ofstream * 1e9 / count << '\n'
+              << "MapStreamWriter           " << writer * 1e9 / count << '\n';
 }
@@ -0,0 +1,109 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "lru.cpp"
+
+// Replays a key trace through LRUCache with every eviction policy:
+// get, and put on a miss, as a read-through cache in front of a backing store does.
+
+// Zipf(0.99) requests over 10 * capacity keys. Every 'period' requests a scan reads
+// 2 * capacity keys that are never requested again, like a periodic batch job.
+vector<int> SyntheticTrace(size_t capacity, size_t requests, size_t period) {
+    const size_t keys = 10 * capacity;
+    vector<double> cdf(keys);
+    double sum = 0;
+    for (size_t k = 0; k < keys; ++k) {
+        sum += 1 / pow(k + 1, 0.99);
+        cdf[k] = sum;
+    }
+
+    mt19937 gen(1);
+    uniform_real_distribution<double> dist(0, sum);
+    vector<int> trace;
+    trace.reserve(requests);
+    int scanned = static_cast<int>(keys);
+    while (trace.size() < requests) {
+        if (trace.size() % period == period - 1) {
+            for (size_t i = 0; i < 2 * capacity && trace.size() < requests; ++i) {
+                trace.push_back(scanned++);
+            }
+        } else {
+            trace.push_back(static_cast<int>(lower_bound(cdf.begin(), cdf.end(), dist(gen)) - cdf.begin()));
+        }
+    }
+    return trace;
+}
+
+// One integer key per line
+vector<int> ReadTrace(const char* path) {
+    ifstream in(path);
+    vector<int> trace;
+    for (int key; in >> key;) {
+        trace.push_back(key);
+    }
+    return trace;
+}
+
+template <class Key, class Policy>
+void Replay(const char* name, size_t capacity, const vector<Key>& trace) {
+    LRUCache<Key, int, Policy> cache(capacity);
+    const auto start = chrono::steady_clock::now();
+    for (const auto& key : trace) {
+        // String keys are looked up by string_view, no std::string is built for a hit
+        if constexpr (is_same_v<Key, string>) {
+            if (cache.get(string_view(key))) {
+                continue;
+            }
+        } else if (cache.get(key)) {
+            continue;
+        }
+        cache.put(key, 0);
+    }
+    const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    const CacheStats stats = cache.stats();
+    printf("%-20s %10.3f %10.2f %10zu %8.2f\n", name, static_cast<double>(stats.hits) / trace.size(),
+           trace.size() / elapsed.count() / 1e6, stats.evictions, stats.averageProbe);
+}
+
+// CLOCK evicts the oldest entry not referenced since the hand last passed it
+bool ClockEvictsOldestUnreferenced() {
+    LRUCache<int, int, ClockPolicy> cache(3);
+    for (int key = 1; key <= 6; ++key) {
+        cache.put(key, key);
+    }
+    const bool oldestGone = !cache.get(1) && !cache.get(2) && !cache.get(3);
+    // 4 is referenced, the hand clears its bit and evicts 5
+    cache.get(4);
+    cache.put(7, 7);
+    return oldestGone && cache.get(4) && !cache.get(5) && cache.get(6) && cache.get(7);
+}
+
+// Usage: cache_trace [trace-file [capacity]]
+int main(int argc, char** argv) {
+    if (!ClockEvictsOldestUnreferenced()) {
+        printf("CLOCK evicts in the wrong order\n");
+        return 1;
+    }
+    const size_t capacity = argc > 2 ? stoull(argv[2]) : 1 << 16;
+    const auto trace = argc > 1 ? ReadTrace(argv[1]) : SyntheticTrace(capacity, 1 << 23, 1 << 20);
+
+    printf("%zu requests, capacity %zu\n", trace.size(), capacity);
+    printf("%-20s %10s %10s %10s %8s\n", "policy", "hit ratio", "Mops", "evictions", "probe");
+    Replay<int, LruPolicy>("LRU", capacity, trace);
+    Replay<int, ClockPolicy>("CLOCK", capacity, trace);
+    Replay<int, SlruPolicy>("SLRU", capacity, trace);
+    Replay<int, TinyLfuPolicy>("W-TinyLFU", capacity, trace);
+
+    vector<string> names(trace.size());
+    for (size_t i = 0; i < trace.size(); ++i) {
+        names[i] = "key:" + to_string(trace[i]);
+    }
+    Replay<string, LruPolicy>("LRU, strings", capacity, names);
+    Replay<string, TinyLfuPolicy>("W-TinyLFU, strings", capacity, names);
+}
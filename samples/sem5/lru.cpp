@@ -1,46 +1,705 @@
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <list>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 using namespace std;
 
+// Eviction policies of LRUCache. Policy::Queue<K, V> owns the entries and decides which
+// ones leave when the total weight would exceed the capacity, the cache maps keys to Queue::Handle:
+//     Handle insert(const K&, V, size_t hash, size_t weight, Evict evict)
+//         adds an entry, evict(key, weight) is called for every entry it drops,
+//         which may be the new entry itself when a policy refuses to admit it
+//     void erase(Handle)
+//     void touch(Handle)        - the entry was hit
+//     void access(size_t hash)  - any lookup, hit or miss
+//     V& value(Handle)
+//     size_t weight(Handle)
+
+// Node of the list based policies, 'segment' tells which list holds it
+template <class K, class V>
+struct CacheNode {
+    K key;
+    V value;
+    size_t hash;
+    size_t weight;
+    uint8_t segment;
+};
+
+// Least recently used entries leave first
+struct LruPolicy {
+    template <class K, class V>
+    class Queue {
+        using List = list<CacheNode<K, V>>;
+
+    public:
+        using Handle = typename List::iterator;
+
+        explicit Queue(size_t capacity) : cap_(capacity) { }
+
+        void access(size_t) { }
+
+        V& value(Handle handle) {
+            return handle->value;
+        }
+
+        size_t weight(Handle handle) const {
+            return handle->weight;
+        }
+
+        void touch(Handle handle) {
+            list_.splice(list_.begin(), list_, handle);
+        }
+
+        void erase(Handle handle) {
+            weight_ -= handle->weight;
+            list_.erase(handle);
+        }
+
+        template <class Evict>
+        Handle insert(const K& key, V value, size_t hash, size_t weight, Evict&& evict) {
+            while (!list_.empty() && weight_ + weight > cap_) {
+                evict(list_.back().key, list_.back().weight);
+                erase(prev(list_.end()));
+            }
+            list_.push_front({key, std::move(value), hash, weight, 0});
+            weight_ += weight;
+            return list_.begin();
+        }
+
+    private:
+        size_t cap_;
+        size_t weight_ = 0;
+        List list_;
+    };
+};
+
+// Entries sit in a ring with a 'referenced' bit, a hit only sets the bit.
+// The hand clears bits until it finds an entry that wasn't referenced since its last pass.
+// Approximates LRU without moving anything on hits.
+struct ClockPolicy {
+    template <class K, class V>
+    class Queue {
+        struct Slot {
+            K key;
+            V value;
+            size_t weight;
+            bool referenced;
+        };
+
+    public:
+        using Handle = size_t;
+
+        explicit Queue(size_t capacity) : cap_(capacity) { }
+
+        void access(size_t) { }
+
+        V& value(Handle handle) {
+            return slots_[handle]->value;
+        }
+
+        size_t weight(Handle handle) const {
+            return slots_[handle]->weight;
+        }
+
+        void touch(Handle handle) {
+            slots_[handle]->referenced = true;
+        }
+
+        void erase(Handle handle) {
+            weight_ -= slots_[handle]->weight;
+            slots_[handle].reset();
+            free_.push_back(handle);
+        }
+
+        template <class Evict>
+        Handle insert(const K& key, V value, size_t, size_t weight, Evict&& evict) {
+            while (weight_ != 0 && weight_ + weight > cap_) {
+                while (!slots_[hand_] || slots_[hand_]->referenced) {
+                    if (slots_[hand_]) {
+                        slots_[hand_]->referenced = false;
+                    }
+                    hand_ = (hand_ + 1) % slots_.size();
+                }
+                evict(slots_[hand_]->key, slots_[hand_]->weight);
+                erase(hand_);
+                // The new entry may take the freed slot, the hand must not stop on it
+                hand_ = (hand_ + 1) % slots_.size();
+            }
+
+            Handle handle = slots_.size();
+            if (free_.empty()) {
+                slots_.emplace_back();
+            } else {
+                handle = free_.back();
+                free_.pop_back();
+            }
+            slots_[handle] = Slot{key, std::move(value), weight, false};
+            weight_ += weight;
+            return handle;
+        }
+
+    private:
+        size_t cap_;
+        size_t weight_ = 0;
+        // Erased slots are empty until an insert reuses them
+        vector<optional<Slot>> slots_;
+        vector<size_t> free_;
+        size_t hand_ = 0;
+    };
+};
+
+// Segmented LRU: new entries go to the probation segment and reach the protected one
+// only on a second hit. A scan touches every key once, so it only churns probation
+// and the protected working set survives it.
+template <class K, class V>
+class Slru {
+public:
+    using List = list<CacheNode<K, V>>;
+    using Handle = typename List::iterator;
+
+    static constexpr uint8_t probation = 1;
+    static constexpr uint8_t guarded = 2;
+
+    // 80% of the capacity is protected
+    explicit Slru(size_t capacity) : cap_(capacity), protectedCap_(capacity * 4 / 5) { }
+
+    size_t capacity() const {
+        return cap_;
+    }
+
+    size_t weight() const {
+        return probationWeight_ + protectedWeight_;
+    }
+
+    bool empty() const {
+        return probation_.empty() && protected_.empty();
+    }
+
+    void touch(Handle handle) {
+        if (handle->segment == guarded) {
+            protected_.splice(protected_.begin(), protected_, handle);
+            return;
+        }
+        protected_.splice(protected_.begin(), probation_, handle);
+        handle->segment = guarded;
+        probationWeight_ -= handle->weight;
+        protectedWeight_ += handle->weight;
+        while (protectedWeight_ > protectedCap_) {
+            const Handle demoted = prev(protected_.end());
+            protectedWeight_ -= demoted->weight;
+            admit(protected_, demoted);
+        }
+    }
+
+    // Moves a node of another list in front of probation
+    void admit(List& from, Handle handle) {
+        probation_.splice(probation_.begin(), from, handle);
+        handle->segment = probation;
+        probationWeight_ += handle->weight;
+    }
+
+    Handle add(CacheNode<K, V> node) {
+        node.segment = probation;
+        probationWeight_ += node.weight;
+        probation_.push_front(std::move(node));
+        return probation_.begin();
+    }
+
+    // The entry to evict, the segments must not be empty
+    Handle victim() {
+        return probation_.empty() ? prev(protected_.end()) : prev(probation_.end());
+    }
+
+    void erase(Handle handle) {
+        if (handle->segment == guarded) {
+            protectedWeight_ -= handle->weight;
+            protected_.erase(handle);
+        } else {
+            probationWeight_ -= handle->weight;
+            probation_.erase(handle);
+        }
+    }
+
+private:
+    size_t cap_;
+    size_t protectedCap_;
+    size_t probationWeight_ = 0;
+    size_t protectedWeight_ = 0;
+    List probation_;
+    List protected_;
+};
+
+struct SlruPolicy {
+    template <class K, class V>
+    class Queue {
+    public:
+        using Handle = typename Slru<K, V>::Handle;
+
+        explicit Queue(size_t capacity) : slru_(capacity) { }
+
+        void access(size_t) { }
+
+        V& value(Handle handle) {
+            return handle->value;
+        }
+
+        size_t weight(Handle handle) const {
+            return handle->weight;
+        }
+
+        void touch(Handle handle) {
+            slru_.touch(handle);
+        }
+
+        void erase(Handle handle) {
+            slru_.erase(handle);
+        }
+
+        template <class Evict>
+        Handle insert(const K& key, V value, size_t hash, size_t weight, Evict&& evict) {
+            while (!slru_.empty() && slru_.weight() + weight > slru_.capacity()) {
+                const Handle victim = slru_.victim();
+                evict(victim->key, victim->weight);
+                slru_.erase(victim);
+            }
+            return slru_.add({key, std::move(value), hash, weight, 0});
+        }
+
+    private:
+        Slru<K, V> slru_;
+    };
+};
+
+// Approximate access counts of recent keys: count-min sketch with four rows of
+// saturating 8-bit counters. Every 10 * capacity increments all counters are halved,
+// so old popularity fades away.
+class FrequencySketch {
+public:
+    explicit FrequencySketch(size_t capacity) : sampleSize_(10 * max<size_t>(capacity, 1)) {
+        size_t width = 64;
+        while (width < capacity) {
+            width *= 2;
+        }
+        counters_.assign(rows * width, 0);
+        mask_ = width - 1;
+    }
+
+    void increment(size_t hash) {
+        for (size_t row = 0; row < rows; ++row) {
+            uint8_t& counter = counters_[index(hash, row)];
+            if (counter < 255) {
+                ++counter;
+            }
+        }
+        if (++additions_ == sampleSize_) {
+            for (auto& counter : counters_) {
+                counter /= 2;
+            }
+            additions_ /= 2;
+        }
+    }
+
+    uint8_t estimate(size_t hash) const {
+        uint8_t result = 255;
+        for (size_t row = 0; row < rows; ++row) {
+            result = min(result, counters_[index(hash, row)]);
+        }
+        return result;
+    }
+
+private:
+    static constexpr size_t rows = 4;
+
+    vector<uint8_t> counters_;
+    size_t mask_;
+    size_t sampleSize_;
+    size_t additions_ = 0;
+
+    // std::hash of integers is identity, every row mixes the hash with its own seed
+    size_t index(size_t hash, size_t row) const {
+        static constexpr uint64_t seeds[rows] = {
+            0x9E3779B97F4A7C15ull, 0xC2B2AE3D27D4EB4Full, 0x165667B19E3779F9ull, 0xD6E8FEB86659FD93ull,
+        };
+        const uint64_t mixed = (hash + row) * seeds[row];
+        return row * (mask_ + 1) + ((mixed >> 32) & mask_);
+    }
+};
+
+// W-TinyLFU: new entries pass through a small LRU window (1%), an entry leaving the window
+// enters the main SLRU only if it was requested more often than the main's victim.
+// One-hit wonders of a scan die in the window, while recency bursts still get cached.
+struct TinyLfuPolicy {
+    template <class K, class V>
+    class Queue {
+        using List = typename Slru<K, V>::List;
+
+        static constexpr uint8_t window = 0;
+
+    public:
+        using Handle = typename List::iterator;
+
+        explicit Queue(size_t capacity)
+            : windowCap_(max<size_t>(1, capacity / 100))
+            , main_(capacity > windowCap_ ? capacity - windowCap_ : 0)
+            , sketch_(capacity)
+        { }
+
+        void access(size_t hash) {
+            sketch_.increment(hash);
+        }
+
+        V& value(Handle handle) {
+            return handle->value;
+        }
+
+        size_t weight(Handle handle) const {
+            return handle->weight;
+        }
+
+        void touch(Handle handle) {
+            if (handle->segment == window) {
+                window_.splice(window_.begin(), window_, handle);
+            } else {
+                main_.touch(handle);
+            }
+        }
+
+        void erase(Handle handle) {
+            if (handle->segment == window) {
+                windowWeight_ -= handle->weight;
+                window_.erase(handle);
+            } else {
+                main_.erase(handle);
+            }
+        }
+
+        template <class Evict>
+        Handle insert(const K& key, V value, size_t hash, size_t weight, Evict&& evict) {
+            window_.push_front({key, std::move(value), hash, weight, window});
+            windowWeight_ += weight;
+            const Handle inserted = window_.begin();
+
+            while (windowWeight_ > windowCap_) {
+                const Handle candidate = prev(window_.end());
+                windowWeight_ -= candidate->weight;
+                if (admit(*candidate, evict)) {
+                    main_.admit(window_, candidate);
+                } else {
+                    evict(candidate->key, candidate->weight);
+                    window_.erase(candidate);
+                }
+            }
+            return inserted;
+        }
+
+    private:
+        size_t windowCap_;
+        size_t windowWeight_ = 0;
+        List window_;
+        Slru<K, V> main_;
+        FrequencySketch sketch_;
+
+    private:
+        // Makes room in the main space for 'candidate' if it beats the first victim
+        template <class Evict>
+        bool admit(const CacheNode<K, V>& candidate, Evict& evict) {
+            if (candidate.weight > main_.capacity()) {
+                return false;
+            }
+            if (main_.weight() + candidate.weight <= main_.capacity()) {
+                return true;
+            }
+            if (sketch_.estimate(candidate.hash) <= sketch_.estimate(main_.victim()->hash)) {
+                return false;
+            }
+            while (main_.weight() + candidate.weight > main_.capacity()) {
+                const Handle victim = main_.victim();
+                evict(victim->key, victim->weight);
+                main_.erase(victim);
+            }
+            return true;
+        }
+    };
+};
+
+// std::hash, except that strings are also looked up by string_view or const char*
+// without building a temporary std::string
+template <class K>
+struct CacheHash : hash<K> {
+};
+
+template <>
+struct CacheHash<string> {
+    using is_transparent = void;
+
+    size_t operator()(string_view key) const {
+        return hash<string_view>{}(key);
+    }
+};
+
+// Every entry weighs 1, the capacity is a number of entries
+struct UnitWeight {
+    template <class K, class V>
+    size_t operator()(const K&, const V&) const {
+        return 1;
+    }
+};
+
+// Counter written only by the thread that currently owns the cache. Increments are a plain
+// load and store, no locked instruction, and any thread may read it at any time.
+class CacheCounter {
+public:
+    void add(size_t n = 1) {
+        value_.store(value_.load(memory_order_relaxed) + n, memory_order_relaxed);
+    }
+
+    void sub(size_t n) {
+        value_.store(value_.load(memory_order_relaxed) - n, memory_order_relaxed);
+    }
+
+    size_t get() const {
+        return value_.load(memory_order_relaxed);
+    }
+
+private:
+    atomic<size_t> value_{0};
+};
+
+// Counters are read one by one, a snapshot taken during a put may be off by that put
+struct CacheStats {
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t evictions = 0;
+    size_t entries = 0;
+    size_t weight = 0;
+    // Nodes in the map bucket of a hit, sampled on every 64th hit
+    double averageProbe = 0;
+};
+
+// 'capacity' limits the total weight of the entries, Weigher(key, value) gives the weight
+// of one, e.g. its size in bytes. Entries heavier than the capacity are not stored.
+template <class K, class V, class Policy = LruPolicy, class Weigher = UnitWeight, class Hash = CacheHash<K>,
+          class Equal = equal_to<>>
 class LRUCache {
+    using Queue = typename Policy::template Queue<K, V>;
+
 public:
-    LRUCache(int capacity) : cap_(capacity) {
-        
-    }
-    
-    int get(int key) {
-        if (map_.find(key) == map_.end()) {
-            return -1;
-        }
-        list_.splice(list_.begin(), list_, map_[key]);
-        return map_[key]->second;
-    }
-    
-    void put(int key, int value) {
-        if (map_.find(key) != map_.end()) {
-            list_.splice(list_.begin(), list_, map_[key]);
-            map_[key]->second = value;
+    LRUCache(size_t capacity, Weigher weigher = {}) : cap_(capacity), queue_(capacity), weigher_(std::move(weigher)) {
+        if constexpr (is_same_v<Weigher, UnitWeight>) {
+            map_.reserve(capacity);
+        }
+    }
+
+    // get hashes 'key' once, put looks it up once and reuses the map iterator.
+    // 'key' may be of any type Hash and Equal accept.
+    template <class Key>
+    optional<V> get(const Key& key) {
+        const size_t hash = hash_(key);
+        return resolve(hash, find(key, hash));
+    }
+
+    void put(K key, V value) {
+        const size_t weight = weigher_(key, value);
+        const size_t hash = hash_(key);
+        const auto [it, inserted] = map_.try_emplace(std::move(key));
+        if (!inserted) {
+            const size_t oldWeight = queue_.weight(it->second);
+            if (weight == oldWeight) {
+                queue_.value(it->second) = std::move(value);
+                queue_.touch(it->second);
+                return;
+            }
+            // The heavier entry may need evictions, it is inserted anew
+            queue_.erase(it->second);
+            weight_.sub(oldWeight);
+            entries_.sub(1);
+        }
+        if (weight > cap_) {
+            map_.erase(it);
             return;
         }
-        if (list_.size() == cap_) {
-            const auto d_key = list_.back().first;
-            list_.pop_back();
-            map_.erase(d_key);
+
+        weight_.add(weight);
+        entries_.add();
+        bool dropped = false;
+        const auto handle = queue_.insert(it->first, std::move(value), hash, weight,
+                                          [&](const K& evicted, size_t evictedWeight) {
+            weight_.sub(evictedWeight);
+            entries_.sub(1);
+            evictions_.add();
+            // Erasing other keys keeps 'it' valid
+            if (equal_(evicted, it->first)) {
+                dropped = true;
+            } else {
+                map_.erase(evicted);
+            }
+        });
+        if (dropped) {
+            map_.erase(it);
+        } else {
+            it->second = handle;
         }
-        list_.push_front({key, value});
-        map_[key] = list_.begin();
+    }
+
+    // values[i] = get(keys[i]) for every i, in order. Keys are resolved in groups:
+    // the group is hashed first, then bucket heads of the whole group are requested, then their
+    // nodes, then the entries, so the cache misses of different keys overlap instead of waiting
+    // for each other. Every key is hashed once. Throws invalid_argument if 'values' is shorter
+    // than 'keys'.
+    void get_many(span<const K> keys, span<optional<V>> values) {
+        if (values.size() < keys.size()) {
+            throw invalid_argument("get_many: fewer values than keys");
+        }
+        size_t hashes[batchSize];
+        Entry* found[batchSize];
+        for (size_t begin = 0; begin < keys.size(); begin += batchSize) {
+            const size_t count = min(batchSize, keys.size() - begin);
+            const auto batch = keys.subspan(begin, count);
+            for (size_t i = 0; i < count; ++i) {
+                hashes[i] = hash_(batch[i]);
+            }
+            prefetchBuckets(span(hashes, count));
+            for (size_t i = 0; i < count; ++i) {
+                found[i] = find(batch[i], hashes[i]);
+                if (found[i] != nullptr) {
+                    __builtin_prefetch(&queue_.value(found[i]->second));
+                }
+            }
+            for (size_t i = 0; i < count; ++i) {
+                values[begin + i] = resolve(hashes[i], found[i]);
+            }
+        }
+    }
+
+    // put(keys[i], values[i]) for every i, in order, with buckets and entries of the keys
+    // already in the cache prefetched like in get_many. put itself hashes the key again,
+    // unordered_map can't insert with a known hash. Throws invalid_argument if 'values' is
+    // shorter than 'keys'.
+    void put_many(span<const K> keys, span<const V> values) {
+        if (values.size() < keys.size()) {
+            throw invalid_argument("put_many: fewer values than keys");
+        }
+        size_t hashes[batchSize];
+        for (size_t begin = 0; begin < keys.size(); begin += batchSize) {
+            const size_t count = min(batchSize, keys.size() - begin);
+            const auto batch = keys.subspan(begin, count);
+            for (size_t i = 0; i < count; ++i) {
+                hashes[i] = hash_(batch[i]);
+            }
+            prefetchBuckets(span(hashes, count));
+            for (size_t i = 0; i < count; ++i) {
+                if (const Entry* entry = find(batch[i], hashes[i])) {
+                    __builtin_prefetch(&queue_.value(entry->second));
+                }
+            }
+            for (size_t i = begin; i < begin + count; ++i) {
+                put(keys[i], values[i]);
+            }
+        }
+    }
+
+    size_t size() const {
+        return map_.size();
+    }
+
+    // Safe to call from any thread while another one uses the cache
+    CacheStats stats() const {
+        CacheStats stats;
+        stats.hits = hits_.get();
+        stats.misses = misses_.get();
+        stats.evictions = evictions_.get();
+        stats.entries = entries_.get();
+        stats.weight = weight_.get();
+        const size_t samples = probeSamples_.get();
+        stats.averageProbe = samples == 0 ? 0.0 : static_cast<double>(probes_.get()) / samples;
+        return stats;
     }
 
 private:
-    const int cap_;
-    list<pair<int, int>> list_;
-    unordered_map<int, list<pair<int, int>>::iterator> map_;
+    using Map = unordered_map<K, typename Queue::Handle, Hash, Equal>;
+    using Entry = typename Map::value_type;
+
+    static constexpr size_t probeSampling = 64;
+    // Enough independent misses to keep the memory system busy, few enough to stay in L1
+    static constexpr size_t batchSize = 16;
+
+    size_t cap_;
+    Queue queue_;
+    [[no_unique_address]] Weigher weigher_;
+    [[no_unique_address]] Hash hash_;
+    [[no_unique_address]] Equal equal_;
+    Map map_;
+
+    CacheCounter hits_;
+    CacheCounter misses_;
+    CacheCounter evictions_;
+    CacheCounter entries_;
+    CacheCounter weight_;
+    CacheCounter probes_;
+    CacheCounter probeSamples_;
+
+private:
+    // unordered_map has no lookup by a known hash, but its buckets are public:
+    // bucket(key) is hash(key) % bucket_count() in libstdc++, libc++ and the MSVC STL
+    size_t bucketOf(size_t hash) const {
+        return hash % map_.bucket_count();
+    }
+
+    template <class Key>
+    Entry* find(const Key& key, size_t hash) {
+        const size_t bucket = bucketOf(hash);
+        for (auto it = map_.begin(bucket); it != map_.end(bucket); ++it) {
+            if (equal_(key, it->first)) {
+                return &*it;
+            }
+        }
+        return nullptr;
+    }
+
+    optional<V> resolve(size_t hash, Entry* entry) {
+        queue_.access(hash);
+        if (entry == nullptr) {
+            misses_.add();
+            return nullopt;
+        }
+        hits_.add();
+        if (hits_.get() % probeSampling == 0) {
+            probes_.add(map_.bucket_size(bucketOf(hash)));
+            probeSamples_.add();
+        }
+        queue_.touch(entry->second);
+        return queue_.value(entry->second);
+    }
+
+    // Reading a bucket head only loads pointers, the loads of different keys don't depend
+    // on each other and run in parallel; the first node of every bucket is prefetched
+    void prefetchBuckets(span<const size_t> hashes) const {
+        for (const size_t hash : hashes) {
+            const size_t bucket = bucketOf(hash);
+            const auto node = map_.begin(bucket);
+            if (node != map_.end(bucket)) {
+                __builtin_prefetch(&*node);
+            }
+        }
+    }
 };
 
 /**
- * Your LRUCache object will be instantiated and called as such:
- * LRUCache* obj = new LRUCache(capacity);
- * int param_1 = obj->get(key);
- * obj->put(key,value);
+ * LRUCache<string, int, TinyLfuPolicy> cache(capacity);
+ * cache.put("key", 1);
+ * optional<int> value = cache.get(string_view("key"));
+ *
+ * auto bytes = [](const string& key, const string& value) { return key.size() + value.size(); };
+ * LRUCache<string, string, LruPolicy, decltype(bytes)> sized(64 << 20, bytes);
  */
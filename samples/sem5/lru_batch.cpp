@@ -0,0 +1,83 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <optional>
+#include <random>
+#include <span>
+#include <vector>
+
+#include "lru.cpp"
+
+// get_many/put_many against loops of single calls on a cache far larger than L3,
+// where nearly every lookup misses every CPU cache level.
+// Requests carry 'requestSize' random keys, as a handler looking up dozens of keys does.
+
+constexpr size_t requestSize = 32;
+
+template <class F>
+double MopsOf(size_t ops, F&& f) {
+    const auto start = chrono::steady_clock::now();
+    f();
+    const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    return ops / elapsed.count() / 1e6;
+}
+
+// Usage: lru_batch [capacity], 1 << 22 entries (a few hundred MB) by default
+int main(int argc, char** argv) {
+    const size_t capacity = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1 << 22;
+    const size_t ops = 1 << 24;
+
+    LRUCache<int, int> cache(capacity);
+    vector<int> fill(capacity);
+    for (size_t i = 0; i < capacity; ++i) {
+        fill[i] = static_cast<int>(i);
+    }
+    cache.put_many(fill, fill);
+
+    // A fifth of the keys are misses
+    mt19937 gen(1);
+    uniform_int_distribution<int> dist(0, static_cast<int>(capacity + capacity / 4) - 1);
+    vector<int> keys(ops);
+    for (auto& key : keys) {
+        key = dist(gen);
+    }
+    vector<optional<int>> values(ops);
+    // A short output span is rejected, not overrun
+    try {
+        cache.get_many(keys, span(values).first(ops / 2));
+    } catch (const invalid_argument& error) {
+        printf("%s\n", error.what());
+    }
+
+    long long sum = 0;
+    const double single = MopsOf(ops, [&] {
+        for (const int key : keys) {
+            sum += cache.get(key).value_or(0);
+        }
+    });
+    const double batched = MopsOf(ops, [&] {
+        for (size_t i = 0; i < ops; i += requestSize) {
+            cache.get_many(span(keys).subspan(i, requestSize), span(values).subspan(i, requestSize));
+        }
+    });
+    for (const auto& value : values) {
+        sum -= value.value_or(0);
+    }
+
+    const double singlePut = MopsOf(ops, [&] {
+        for (const int key : keys) {
+            cache.put(key, key);
+        }
+    });
+    const double batchedPut = MopsOf(ops, [&] {
+        for (size_t i = 0; i < ops; i += requestSize) {
+            const auto request = span<const int>(keys).subspan(i, requestSize);
+            cache.put_many(request, request);
+        }
+    });
+
+    printf("capacity %zu, %zu keys per request, checksum %lld\n", capacity, requestSize, sum);
+    printf("%-6s %12s %12s %8s\n", "", "single, Mops", "many, Mops", "gain");
+    printf("%-6s %12.2f %12.2f %7.2fx\n", "get", single, batched, batched / single);
+    printf("%-6s %12.2f %12.2f %7.2fx\n", "put", singlePut, batchedPut, batchedPut / singlePut);
+}
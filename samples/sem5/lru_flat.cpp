@@ -0,0 +1,197 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "lru.cpp"
+
+// LRUCache without allocations after construction.
+// Entries live in one array and form the recency list through indices, the hash table
+// is open addressing with linear probing and stores keys next to entry indices,
+// so a hit reads one table slot and one entry. Both arrays are sized by the constructor.
+class FlatLRUCache {
+public:
+    FlatLRUCache(int capacity)
+        : entries_(max(capacity, 0))
+        , shift_(64 - TableBits(entries_.size()))
+        , table_(size_t(1) << (64 - shift_))
+    { }
+
+    optional<int> get(int key) {
+        const size_t slot = find(key);
+        if (table_[slot].entry == none) {
+            return nullopt;
+        }
+        const uint32_t entry = table_[slot].entry;
+        moveToFront(entry);
+        return entries_[entry].value;
+    }
+
+    void put(int key, int value) {
+        size_t slot = find(key);
+        if (table_[slot].entry != none) {
+            const uint32_t entry = table_[slot].entry;
+            entries_[entry].value = value;
+            moveToFront(entry);
+            return;
+        }
+        if (entries_.empty()) {
+            return;
+        }
+
+        uint32_t entry;
+        if (size_ < entries_.size()) {
+            entry = size_++;
+        } else {
+            entry = tail_;
+            unlink(entry);
+            erase(find(entries_[entry].key));
+            // Erasing shifts slots back, the free slot for 'key' may have moved
+            slot = find(key);
+        }
+        entries_[entry].key = key;
+        entries_[entry].value = value;
+        table_[slot] = {key, entry};
+        pushFront(entry);
+    }
+
+private:
+    static constexpr uint32_t none = UINT32_MAX;
+
+    struct Entry {
+        int key;
+        int value;
+        uint32_t prev;
+        uint32_t next;
+    };
+
+    struct Slot {
+        int key = 0;
+        uint32_t entry = none;
+    };
+
+    vector<Entry> entries_;
+    // The table has a power of two slots, at least twice the capacity
+    int shift_;
+    vector<Slot> table_;
+    uint32_t size_ = 0;
+    uint32_t head_ = none;
+    uint32_t tail_ = none;
+
+private:
+    static int TableBits(size_t capacity) {
+        int bits = 1;
+        while ((size_t(1) << bits) < 2 * capacity) {
+            ++bits;
+        }
+        return bits;
+    }
+
+    // Fibonacci hashing: the high bits of the product depend on all bits of the key
+    size_t home(int key) const {
+        return static_cast<uint32_t>(key) * 0x9E3779B97F4A7C15ull >> shift_;
+    }
+
+    size_t mask() const {
+        return table_.size() - 1;
+    }
+
+    // Slot holding 'key' or the empty slot where it would be inserted
+    size_t find(int key) const {
+        size_t slot = home(key);
+        while (table_[slot].entry != none && table_[slot].key != key) {
+            slot = (slot + 1) & mask();
+        }
+        return slot;
+    }
+
+    // Backward shift deletion: later slots of the probe chain move into the hole,
+    // so the table never has tombstones and lookups don't degrade over time
+    void erase(size_t slot) {
+        for (size_t next = (slot + 1) & mask(); table_[next].entry != none; next = (next + 1) & mask()) {
+            const size_t distance = (next - home(table_[next].key)) & mask();
+            if (distance >= ((next - slot) & mask())) {
+                table_[slot] = table_[next];
+                slot = next;
+            }
+        }
+        table_[slot].entry = none;
+    }
+
+    void unlink(uint32_t entry) {
+        Entry& e = entries_[entry];
+        (e.prev == none ? head_ : entries_[e.prev].next) = e.next;
+        (e.next == none ? tail_ : entries_[e.next].prev) = e.prev;
+    }
+
+    void pushFront(uint32_t entry) {
+        Entry& e = entries_[entry];
+        e.prev = none;
+        e.next = head_;
+        (head_ == none ? tail_ : entries_[head_].prev) = entry;
+        head_ = entry;
+    }
+
+    void moveToFront(uint32_t entry) {
+        if (entry != head_) {
+            unlink(entry);
+            pushFront(entry);
+        }
+    }
+};
+
+// Keys 0..n-1 with P(k) proportional to 1 / (k + 1)^s, shuffled so that hot keys
+// don't sit next to each other
+vector<int> ZipfKeys(size_t n, size_t count, double s, uint32_t seed) {
+    vector<double> cdf(n);
+    double sum = 0;
+    for (size_t k = 0; k < n; ++k) {
+        sum += 1 / pow(k + 1, s);
+        cdf[k] = sum;
+    }
+    vector<int> names(n);
+    for (size_t k = 0; k < n; ++k) {
+        names[k] = static_cast<int>(k);
+    }
+    mt19937 gen(seed);
+    shuffle(names.begin(), names.end(), gen);
+
+    uniform_real_distribution<double> dist(0, sum);
+    vector<int> keys(count);
+    for (auto& key : keys) {
+        key = names[lower_bound(cdf.begin(), cdf.end(), dist(gen)) - cdf.begin()];
+    }
+    return keys;
+}
+
+// get, and put on a miss, the usual read-through pattern
+template <class Cache>
+void Replay(const char* name, int capacity, const vector<int>& keys) {
+    Cache cache(capacity);
+    size_t hits = 0;
+    const auto start = chrono::steady_clock::now();
+    for (const int key : keys) {
+        if (cache.get(key)) {
+            ++hits;
+        } else {
+            cache.put(key, key);
+        }
+    }
+    const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    printf("%-10s %10d %12.2f %10.3f\n", name, capacity, keys.size() / elapsed.count() / 1e6,
+           static_cast<double>(hits) / keys.size());
+}
+
+int main() {
+    constexpr size_t requests = 1 << 23;
+    printf("%-10s %10s %12s %10s\n", "cache", "capacity", "Mops", "hit ratio");
+    for (const int capacity : {1 << 10, 1 << 16, 1 << 20}) {
+        // Ten times more keys than the cache holds, Zipf skew 0.99 like typical web traces
+        const auto keys = ZipfKeys(10 * capacity, requests, 0.99, 1);
+        Replay<LRUCache<int, int>>("list", capacity, keys);
+        Replay<FlatLRUCache>("flat", capacity, keys);
+    }
+}
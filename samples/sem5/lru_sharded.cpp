@@ -0,0 +1,158 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "lru.cpp"
+
+// LRUCache split into shards by key hash, every shard has its own lock.
+// Threads working with different shards don't contend, so throughput grows with
+// the number of cores as long as there are several times more shards than threads.
+// Eviction is per shard: the evicted key is the least recently used one of its shard,
+// which is close to the global LRU order when keys are spread evenly.
+template <class K, class V, class Policy = LruPolicy>
+class ShardedLRUCache {
+public:
+    ShardedLRUCache(size_t capacity, size_t shards = 64) {
+        const size_t shardCapacity = (capacity + shards - 1) / shards;
+        shards_.reserve(shards);
+        for (size_t i = 0; i < shards; ++i) {
+            shards_.push_back(make_unique<Shard>(shardCapacity));
+        }
+    }
+
+    template <class Key>
+    optional<V> get(const Key& key) {
+        Shard& shard = shardOf(key);
+        lock_guard lock(shard.lock);
+        return shard.cache.get(key);
+    }
+
+    void put(K key, V value) {
+        Shard& shard = shardOf(key);
+        lock_guard lock(shard.lock);
+        shard.cache.put(std::move(key), std::move(value));
+    }
+
+    // Sums the counters of all shards without taking their locks. The probe length is
+    // averaged over hits, a shard counts as much as it is hit.
+    CacheStats stats() const {
+        CacheStats total;
+        double probes = 0;
+        for (const auto& shard : shards_) {
+            const CacheStats stats = shard->cache.stats();
+            total.hits += stats.hits;
+            total.misses += stats.misses;
+            total.evictions += stats.evictions;
+            total.entries += stats.entries;
+            total.weight += stats.weight;
+            probes += stats.averageProbe * stats.hits;
+        }
+        total.averageProbe = total.hits == 0 ? 0.0 : probes / total.hits;
+        return total;
+    }
+
+private:
+    // A shard per cache line, neighbouring locks don't share it
+    struct alignas(64) Shard {
+        explicit Shard(size_t capacity) : cache(capacity) { }
+
+        std::mutex lock;
+        LRUCache<K, V, Policy> cache;
+    };
+
+    vector<unique_ptr<Shard>> shards_;
+
+    // std::hash<int> is identity. libstdc++ picks buckets by the hash modulo a prime, maps with
+    // power of two bucket counts by its low bits: sharding by the low bits would leave such a map
+    // only keys with equal low bits, crowded into a fraction of its buckets. The shard is taken
+    // from the high bits of a multiplicative hash, which works whichever way a map picks buckets.
+    template <class Key>
+    Shard& shardOf(const Key& key) {
+        const uint64_t hash = static_cast<uint32_t>(CacheHash<K>{}(key)) * 0x9E3779B97F4A7C15ull;
+        return *shards_[(hash >> 32) * shards_.size() >> 32];
+    }
+};
+
+// The same interface over one LRUCache under one mutex, the baseline
+class LockedLRUCache {
+public:
+    LockedLRUCache(size_t capacity) : cache_(capacity) { }
+
+    optional<int> get(int key) {
+        lock_guard lock(mutex_);
+        return cache_.get(key);
+    }
+
+    void put(int key, int value) {
+        lock_guard lock(mutex_);
+        cache_.put(key, value);
+    }
+
+    CacheStats stats() const {
+        return cache_.stats();
+    }
+
+private:
+    mutex mutex_;
+    LRUCache<int, int> cache_;
+};
+
+constexpr size_t capacity = 1 << 18;
+constexpr size_t opsPerThread = 1 << 20;
+
+// 90% get, 10% put over twice as many keys as the cache holds, misses are filled with put
+struct Result {
+    double mops;
+    double hitRatio;
+};
+
+template <class Cache>
+Result Throughput(size_t threads) {
+    Cache cache(capacity);
+    vector<vector<int>> keys(threads);
+    for (size_t t = 0; t < threads; ++t) {
+        mt19937 gen(t);
+        uniform_int_distribution<int> dist(0, 2 * capacity - 1);
+        keys[t].resize(opsPerThread);
+        for (auto& key : keys[t]) {
+            key = dist(gen);
+        }
+    }
+
+    const auto start = chrono::steady_clock::now();
+    {
+        vector<jthread> workers;
+        for (size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&cache, &keys = keys[t]] {
+                for (size_t i = 0; i < keys.size(); ++i) {
+                    const int key = keys[i];
+                    if (i % 10 == 0 || !cache.get(key)) {
+                        cache.put(key, key);
+                    }
+                }
+            });
+        }
+    }
+    const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    const CacheStats stats = cache.stats();
+    return {threads * opsPerThread / elapsed.count() / 1e6,
+            static_cast<double>(stats.hits) / (stats.hits + stats.misses)};
+}
+
+// Usage: lru_sharded [max-threads], hardware concurrency by default
+int main(int argc, char** argv) {
+    const size_t maxThreads = argc > 1 ? strtoull(argv[1], nullptr, 10) : max(1u, thread::hardware_concurrency());
+    printf("%-8s %14s %10s %14s %10s\n", "threads", "locked, Mops", "hit ratio", "sharded, Mops", "hit ratio");
+    for (size_t threads = 1; threads <= maxThreads; threads *= 2) {
+        const Result locked = Throughput<LockedLRUCache>(threads);
+        const Result sharded = Throughput<ShardedLRUCache<int, int>>(threads);
+        printf("%-8zu %14.2f %10.3f %14.2f %10.3f\n", threads, locked.mops, locked.hitRatio, sharded.mops,
+               sharded.hitRatio);
+    }
+}
@@ -0,0 +1,384 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <cstdio>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Random access version of Iota from iota.cpp: the element i is computed as first + i * step,
+// so the iterator jumps anywhere in O(1), size() is known and the range splits into parts
+// for threads. Works for any integer type and for floating point steps.
+// Integer elements are computed in the unsigned type, which can't overflow, so ranges ending
+// near numeric_limits<T>::max() or with huge steps are fine.
+template <class T>
+    requires std::integral<T> || std::floating_point<T>
+class IotaRange : public std::ranges::view_interface<IotaRange<T>> {
+    using Wide = typename std::conditional_t<std::integral<T>, std::make_unsigned<T>, std::type_identity<T>>::type;
+
+public:
+    class Iterator {
+    public:
+        using iterator_concept = std::random_access_iterator_tag;
+        using iterator_category = std::input_iterator_tag;
+        using value_type = T;
+        using difference_type = std::int64_t;
+
+        Iterator() = default;
+
+        Iterator(T first, T step, std::uint64_t index) : First_(first), Step_(step), Index_(index) { }
+
+        T operator*() const {
+            return IotaRange::At(First_, Step_, Index_);
+        }
+
+        T operator[](difference_type n) const {
+            return IotaRange::At(First_, Step_, Index_ + static_cast<std::uint64_t>(n));
+        }
+
+        Iterator& operator++() {
+            ++Index_;
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator copy = *this;
+            ++Index_;
+            return copy;
+        }
+
+        Iterator& operator--() {
+            --Index_;
+            return *this;
+        }
+
+        Iterator operator--(int) {
+            Iterator copy = *this;
+            --Index_;
+            return copy;
+        }
+
+        Iterator& operator+=(difference_type n) {
+            Index_ += static_cast<std::uint64_t>(n);
+            return *this;
+        }
+
+        Iterator& operator-=(difference_type n) {
+            Index_ -= static_cast<std::uint64_t>(n);
+            return *this;
+        }
+
+        friend Iterator operator+(Iterator it, difference_type n) {
+            return it += n;
+        }
+
+        friend Iterator operator+(difference_type n, Iterator it) {
+            return it += n;
+        }
+
+        friend Iterator operator-(Iterator it, difference_type n) {
+            return it -= n;
+        }
+
+        // Wraps for iterators more than INT64_MAX apart, a signed difference can't hold that
+        friend difference_type operator-(const Iterator& lhs, const Iterator& rhs) {
+            return static_cast<difference_type>(lhs.Index_ - rhs.Index_);
+        }
+
+        friend bool operator==(const Iterator& lhs, const Iterator& rhs) {
+            return lhs.Index_ == rhs.Index_;
+        }
+
+        friend auto operator<=>(const Iterator& lhs, const Iterator& rhs) {
+            return lhs.Index_ <=> rhs.Index_;
+        }
+
+    private:
+        T First_{};
+        T Step_{};
+        // Unsigned, an uint64_t range may hold more than INT64_MAX elements
+        std::uint64_t Index_ = 0;
+    };
+
+    IotaRange() = default;
+
+    // Elements from 'first' up to 'last' exclusive, 'last' doesn't have to be reachable
+    IotaRange(T first, T last, T step = 1) : First_(first), Step_(step), Size_(Count(first, last, step)) { }
+
+    Iterator begin() const {
+        return Iterator(First_, Step_, Base_);
+    }
+
+    Iterator end() const {
+        return Iterator(First_, Step_, Base_ + Size_);
+    }
+
+    std::size_t size() const {
+        return Size_;
+    }
+
+    T operator[](std::size_t i) const {
+        return At(First_, Step_, Base_ + i);
+    }
+
+    // Part 'index' of 'parts' nearly equal parts, the parts cover the range in order.
+    // A part keeps the first element and offsets the indices, so its elements are computed
+    // exactly as the whole range computes them: floating point values don't depend on the split.
+    IotaRange part(std::size_t index, std::size_t parts) const {
+        const std::size_t from = Size_ / parts * index + std::min(index, Size_ % parts);
+        const std::size_t to = from + Size_ / parts + (index < Size_ % parts ? 1 : 0);
+        return IotaRange(First_, Step_, Base_ + from, to - from, Tag{});
+    }
+
+    // Writes the range into 'out', which must hold size() elements. Every element is computed
+    // from its index independently, so the compiler vectorizes the loop.
+    void fill(std::span<T> out) const {
+        const T first = First_;
+        const T step = Step_;
+        const std::size_t base = Base_;
+        const std::size_t size = Size_;
+        T* data = out.data();
+        if constexpr (std::floating_point<T>) {
+            // Vector conversion from int32 is in SSE2, from int64 only in AVX-512
+            if (base + size <= INT32_MAX) {
+                const auto from = static_cast<std::int32_t>(base);
+                for (std::int32_t i = 0; i < static_cast<std::int32_t>(size); ++i) {
+                    data[i] = first + static_cast<T>(from + i) * step;
+                }
+                return;
+            }
+        }
+        for (std::size_t i = 0; i < size; ++i) {
+            data[i] = At(first, step, base + i);
+        }
+    }
+
+private:
+    struct Tag { };
+
+    T First_{};
+    T Step_{};
+    // Index of the first element, non-zero for parts
+    std::size_t Base_ = 0;
+    std::size_t Size_ = 0;
+
+    IotaRange(T first, T step, std::size_t base, std::size_t size, Tag)
+        : First_(first), Step_(step), Base_(base), Size_(size) { }
+
+    static T At(T first, T step, std::uint64_t i) {
+        if constexpr (std::integral<T>) {
+            return static_cast<T>(static_cast<Wide>(first) + static_cast<Wide>(i) * static_cast<Wide>(step));
+        } else {
+            return first + static_cast<T>(static_cast<std::int64_t>(i)) * step;
+        }
+    }
+
+    // ceil((last - first) / step) without overflow: the distance and the step are taken
+    // as unsigned magnitudes, which always fit
+    static std::size_t Count(T first, T last, T step) {
+        if (step == 0) {
+            throw std::invalid_argument("IotaRange step must not be zero");
+        }
+        if constexpr (std::floating_point<T>) {
+            if (!std::isfinite(first) || !std::isfinite(last) || !std::isfinite(step)) {
+                throw std::invalid_argument("IotaRange bounds and step must be finite");
+            }
+            if (first + step == first) {
+                throw std::invalid_argument("IotaRange step is too small to advance from first");
+            }
+        }
+        if (step > 0 ? last <= first : last >= first) {
+            return 0;
+        }
+        if constexpr (std::integral<T>) {
+            const Wide distance = step > 0 ? static_cast<Wide>(last) - static_cast<Wide>(first)
+                                           : static_cast<Wide>(first) - static_cast<Wide>(last);
+            const Wide magnitude = step > 0 ? static_cast<Wide>(step) : Wide(0) - static_cast<Wide>(step);
+            return distance / magnitude + (distance % magnitude != 0 ? 1 : 0);
+        } else {
+            // The quotient of finite values may still overflow to inf or exceed the index type
+            const T estimate = std::ceil((last - first) / step);
+            if (!(estimate < static_cast<T>(INT64_MAX))) {
+                throw std::length_error("IotaRange has too many elements");
+            }
+            // Elements are first + i * step, so the count is checked against that exact formula.
+            // The estimate is off by rounding only, a couple of steps each way correct it,
+            // and the loops stay bounded however the values round.
+            const auto beyond = [&](std::size_t i) {
+                return step > 0 ? At(first, step, i) >= last : At(first, step, i) <= last;
+            };
+            std::size_t count = static_cast<std::size_t>(estimate);
+            for (int i = 0; i < 2 && count > 0 && beyond(count - 1); ++i) {
+                --count;
+            }
+            for (int i = 0; i < 2 && !beyond(count); ++i) {
+                ++count;
+            }
+            return count;
+        }
+    }
+};
+
+static_assert(std::ranges::random_access_range<IotaRange<int>>);
+static_assert(std::ranges::sized_range<IotaRange<double>>);
+static_assert(std::ranges::view<IotaRange<std::int64_t>>);
+
+namespace detail {
+
+inline std::size_t Threads(std::size_t threads) {
+    return threads != 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Calls work(part, range.part(part, parts)) on 'parts' threads, part 0 on the calling one
+template <class T, class Work>
+void ForEachPart(const IotaRange<T>& range, std::size_t parts, Work work) {
+    std::vector<std::jthread> workers;
+    for (std::size_t part = 1; part < parts; ++part) {
+        workers.emplace_back([&, part] { work(part, range.part(part, parts)); });
+    }
+    work(0, range.part(0, parts));
+}
+
+} // namespace detail
+
+// f(x) for every element, 'threads' = 0 means one per core
+template <class T, class F>
+void parallel_for_each(const IotaRange<T>& range, F f, std::size_t threads = 0) {
+    detail::ForEachPart(range, detail::Threads(threads), [&](std::size_t, const IotaRange<T>& part) {
+        for (T x : part) {
+            f(x);
+        }
+    });
+}
+
+// out[i] = f(range[i])
+template <class T, std::random_access_iterator Out, class F>
+void parallel_transform(const IotaRange<T>& range, Out out, F f, std::size_t threads = 0) {
+    const std::size_t parts = detail::Threads(threads);
+    detail::ForEachPart(range, parts, [&](std::size_t index, const IotaRange<T>& part) {
+        Out it = out + (range.size() / parts * index + std::min(index, range.size() % parts));
+        for (T x : part) {
+            *it++ = f(x);
+        }
+    });
+}
+
+// op(... op(init, map(range[0])) ..., map(range[n - 1])), parts are reduced separately and
+// then combined in order, so 'op' must be associative
+template <class T, class R, class Op = std::plus<>, class Map = std::identity>
+R parallel_reduce(const IotaRange<T>& range, R init, Op op = {}, Map map = {}, std::size_t threads = 0) {
+    const std::size_t parts = detail::Threads(threads);
+    // One optional per part: threads writing neighbouring flags of a vector<bool> would race
+    std::vector<std::optional<R>> results(parts);
+    detail::ForEachPart(range, parts, [&](std::size_t index, const IotaRange<T>& part) {
+        if (part.size() == 0) {
+            return;
+        }
+        R result = map(part[0]);
+        for (std::size_t i = 1; i < part.size(); ++i) {
+            result = op(std::move(result), map(part[i]));
+        }
+        results[index] = std::move(result);
+    });
+    for (auto& result : results) {
+        if (result) {
+            init = op(std::move(init), std::move(*result));
+        }
+    }
+    return init;
+}
+
+template <class F>
+double Measure(F&& f) {
+    constexpr int iterations = 10;
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        f();
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+}
+
+int main() {
+    for (int x : IotaRange(20, 10, -2)) {
+        std::printf("%d ", x);
+    }
+    std::printf("\n");
+    // The end near the type's limit and a step that would overflow a naive counter
+    const IotaRange<std::int8_t> edge(100, 127, 10);
+    std::printf("int8 [100, 127) by 10: size %zu, last %d\n", edge.size(), edge.back());
+    const IotaRange<std::uint64_t> huge(0, UINT64_MAX, UINT64_MAX / 3);
+    std::printf("uint64 by max / 3: size %zu\n", huge.size());
+    // More than INT64_MAX elements, the iterators index them unsigned
+    const IotaRange<std::uint64_t> all(0, UINT64_MAX);
+    std::printf("uint64 [0, max): size %zu, last %zu\n", all.size(), static_cast<std::size_t>(*(all.end() - 1)));
+    try {
+        IotaRange<double>(0.0, std::numeric_limits<double>::infinity());
+    } catch (const std::invalid_argument& error) {
+        std::printf("[0, inf): %s\n", error.what());
+    }
+    const IotaRange<double> tenths(0.0, 1.0, 0.1);
+    std::printf("[0, 1) by 0.1: size %zu, back %.17g\n", tenths.size(), tenths.back());
+    // Parts compute every element from the same first value, the split must not change them
+    bool same = true;
+    const IotaRange<double> hundredths(-1.0, 1.0, 0.01);
+    for (std::size_t threads = 1; threads <= 7; ++threads) {
+        std::vector<double> values(hundredths.size());
+        parallel_transform(hundredths, values.begin(), std::identity{}, threads);
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            same &= values[i] == hundredths[i];
+        }
+        for (std::size_t part = 0; part < threads; ++part) {
+            const auto range = hundredths.part(part, threads);
+            std::vector<double> filled(range.size());
+            range.fill(filled);
+            same &= std::ranges::equal(filled, range) && (range.empty() || range.back() < 1.0);
+        }
+    }
+    std::printf("parts of [-1, 1) by 0.01 match operator[] for 1..7 threads: %s\n", same ? "yes" : "no");
+    // Random access: O(1) lower_bound through std algorithms
+    const IotaRange<std::int64_t> odd(1, 1'000'000'001, 2);
+    std::printf("lower_bound(odd, 777): index %td\n\n", std::ranges::lower_bound(odd, 777) - odd.begin());
+
+    constexpr std::size_t size = 1 << 24;
+    std::vector<int> ints(size);
+    std::vector<float> floats(size);
+    const IotaRange<int> indices(0, static_cast<int>(size) * 3, 3);
+    const IotaRange<float> reals(0.0f, size * 0.5f, 0.5f);
+    volatile int sink;
+
+    std::printf("%-28s %10s\n", "fill 16M elements, ms", "");
+    std::printf("%-28s %10.2f\n", "loop over Iota-like ++",
+                Measure([&] {
+                    int value = 0;
+                    for (auto& x : ints) {
+                        x = value;
+                        value += 3;
+                    }
+                    sink = ints.back();
+                }));
+    std::printf("%-28s %10.2f\n", "std::ranges::copy(iota)",
+                Measure([&] { std::ranges::copy(indices, ints.begin()); sink = ints.back(); }));
+    std::printf("%-28s %10.2f\n", "IotaRange::fill, int",
+                Measure([&] { indices.fill(ints); sink = ints.back(); }));
+    std::printf("%-28s %10.2f\n", "IotaRange::fill, float",
+                Measure([&] { reals.fill(floats); sink = static_cast<int>(floats.back()); }));
+
+    const IotaRange<std::int64_t> space(0, 1'000'000'000);
+    const auto square = [](std::int64_t x) { return x * x % 7; };
+    const std::size_t hardware = detail::Threads(0);
+    std::printf("\n%-28s %10s\n", "reduce over 1e9 indices", "ms");
+    for (std::size_t threads = 1; threads <= hardware; threads *= 2) {
+        std::int64_t sum = 0;
+        const double ms = Measure([&] { sum = parallel_reduce(space, std::int64_t(0), std::plus<>{}, square, threads); });
+        std::printf("%-28zu %10.2f  sum %lld\n", threads, ms, static_cast<long long>(sum));
+    }
+}
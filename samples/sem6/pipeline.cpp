@@ -0,0 +1,479 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <concepts>
+#include <cstdio>
+#include <functional>
+#include <iterator>
+#include <numeric>
+#include <random>
+#include <ranges>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// The pipeline from view.cpp, fused at compile time:
+//     auto out = v | filter(even) | transform(half) | take(3) | to_vector();
+// Stages are plain structs, the terminal operation (for_each, reduce, to_vector) nests them
+// into one chain of sinks and pushes every element of the range through it in a single loop.
+// Elements travel as function arguments, nothing is stored between stages.
+
+namespace pipeline {
+
+struct StageBase { };
+
+template <class S>
+concept Stage = std::derived_from<S, StageBase>;
+
+// A sink takes elements with push(x), which returns false once no more are needed,
+// and finish() when the range is over.
+// Stage::Output<In> is the type the stage passes on when it gets 'In',
+// Stage::sink<In>(next) wraps the next sink.
+
+template <class P>
+struct Filter : StageBase {
+    P p;
+
+    template <class In>
+    using Output = In;
+
+    template <class In, class Next>
+    struct Sink {
+        P p;
+        Next next;
+
+        template <class T>
+        bool push(T&& x) {
+            return !std::invoke(p, std::as_const(x)) || next.push(std::forward<T>(x));
+        }
+
+        void finish() {
+            next.finish();
+        }
+    };
+
+    template <class In, class Next>
+    auto sink(Next next) const {
+        return Sink<In, Next>{p, std::move(next)};
+    }
+};
+
+template <class F>
+struct Transform : StageBase {
+    F f;
+
+    template <class In>
+    using Output = std::invoke_result_t<const F&, In>;
+
+    template <class In, class Next>
+    struct Sink {
+        F f;
+        Next next;
+
+        template <class T>
+        bool push(T&& x) {
+            return next.push(std::invoke(f, std::forward<T>(x)));
+        }
+
+        void finish() {
+            next.finish();
+        }
+    };
+
+    template <class In, class Next>
+    auto sink(Next next) const {
+        return Sink<In, Next>{f, std::move(next)};
+    }
+};
+
+// Passes on f(x) for the elements satisfying p, the rest is dropped: copy_if and transform
+// from transform_if.cpp in one step
+template <class P, class F>
+struct TransformIf : StageBase {
+    P p;
+    F f;
+
+    template <class In>
+    using Output = std::invoke_result_t<const F&, In>;
+
+    template <class In, class Next>
+    struct Sink {
+        P p;
+        F f;
+        Next next;
+
+        template <class T>
+        bool push(T&& x) {
+            return !std::invoke(p, std::as_const(x)) || next.push(std::invoke(f, std::forward<T>(x)));
+        }
+
+        void finish() {
+            next.finish();
+        }
+    };
+
+    template <class In, class Next>
+    auto sink(Next next) const {
+        return Sink<In, Next>{p, f, std::move(next)};
+    }
+};
+
+// Stops the whole loop after 'n' elements
+struct Take : StageBase {
+    size_t n;
+
+    template <class In>
+    using Output = In;
+
+    template <class In, class Next>
+    struct Sink {
+        size_t left;
+        Next next;
+
+        template <class T>
+        bool push(T&& x) {
+            if (left == 0) {
+                return false;
+            }
+            --left;
+            return next.push(std::forward<T>(x)) && left != 0;
+        }
+
+        void finish() {
+            next.finish();
+        }
+    };
+
+    template <class In, class Next>
+    auto sink(Next next) const {
+        return Sink<In, Next>{n, std::move(next)};
+    }
+};
+
+// Groups elements by N into a buffer inside the sink and passes on a span over it,
+// the last chunk may be shorter. The span is valid only during the call.
+template <size_t N>
+struct Chunk : StageBase {
+    static_assert(N > 0);
+
+    template <class In>
+    using Output = std::span<const std::remove_cvref_t<In>>;
+
+    template <class In, class Next>
+    struct Sink {
+        std::array<std::remove_cvref_t<In>, N> buffer{};
+        size_t size = 0;
+        Next next;
+
+        template <class T>
+        bool push(T&& x) {
+            buffer[size++] = std::forward<T>(x);
+            if (size < N) {
+                return true;
+            }
+            size = 0;
+            return next.push(Output<In>(buffer));
+        }
+
+        void finish() {
+            if (size != 0) {
+                next.push(Output<In>(buffer.data(), size));
+            }
+            next.finish();
+        }
+    };
+
+    template <class In, class Next>
+    auto sink(Next next) const {
+        return Sink<In, Next>{{}, 0, std::move(next)};
+    }
+};
+
+template <class F>
+struct ForEach {
+    F f;
+
+    template <class In>
+    struct Sink {
+        F* f;
+
+        template <class T>
+        bool push(T&& x) {
+            std::invoke(*f, std::forward<T>(x));
+            return true;
+        }
+
+        void finish() { }
+    };
+
+    template <class In>
+    auto sink() {
+        return Sink<In>{&f};
+    }
+};
+
+template <class T, class Op>
+struct Reduce {
+    T value;
+    Op op;
+
+    template <class In>
+    struct Sink {
+        Reduce* self;
+
+        template <class U>
+        bool push(U&& x) {
+            self->value = std::invoke(self->op, std::move(self->value), std::forward<U>(x));
+            return true;
+        }
+
+        void finish() { }
+    };
+
+    template <class In>
+    auto sink() {
+        return Sink<In>{this};
+    }
+
+    T result() {
+        return std::move(value);
+    }
+};
+
+// The only allocation of a pipeline is the result vector. 'reserve' may be a known upper bound.
+struct ToVector {
+    size_t reserve = 0;
+
+    template <class In>
+    struct Collector {
+        std::vector<std::remove_cvref_t<In>> values;
+
+        struct Sink {
+            Collector* self;
+
+            template <class T>
+            bool push(T&& x) {
+                self->values.push_back(std::forward<T>(x));
+                return true;
+            }
+
+            void finish() { }
+        };
+    };
+};
+
+template <Stage... Stages>
+struct Pipeline {
+    std::tuple<Stages...> stages;
+};
+
+// A range with the stages to run over it, completed by a terminal operation
+template <std::ranges::view V, class... Stages>
+struct Bound {
+    V range;
+    std::tuple<Stages...> stages;
+};
+
+namespace detail {
+
+template <class In, size_t I, class Stages, class MakeTerminalSink>
+auto BuildSink(const Stages& stages, MakeTerminalSink& makeTerminalSink) {
+    if constexpr (I == std::tuple_size_v<Stages>) {
+        return makeTerminalSink.template operator()<In>();
+    } else {
+        const auto& stage = std::get<I>(stages);
+        using Out = typename std::remove_cvref_t<decltype(stage)>::template Output<In>;
+        return stage.template sink<In>(BuildSink<Out, I + 1>(stages, makeTerminalSink));
+    }
+}
+
+// The element type reaching the terminal
+template <class In, class... Stages>
+struct OutputOf {
+    using type = In;
+};
+
+template <class In, class S, class... Stages>
+struct OutputOf<In, S, Stages...> {
+    using type = typename OutputOf<typename S::template Output<In>, Stages...>::type;
+};
+
+template <class V, class Stages, class MakeTerminalSink>
+void Run(V& range, const Stages& stages, MakeTerminalSink makeTerminalSink) {
+    auto sink = BuildSink<std::ranges::range_reference_t<V>, 0>(stages, makeTerminalSink);
+    for (auto&& x : range) {
+        if (!sink.push(std::forward<decltype(x)>(x))) {
+            break;
+        }
+    }
+    sink.finish();
+}
+
+} // namespace detail
+
+template <class P>
+Filter<P> filter(P p) {
+    return {{}, std::move(p)};
+}
+
+template <class F>
+Transform<F> transform(F f) {
+    return {{}, std::move(f)};
+}
+
+template <class P, class F>
+TransformIf<P, F> transform_if(P p, F f) {
+    return {{}, std::move(p), std::move(f)};
+}
+
+inline Take take(size_t n) {
+    return {{}, n};
+}
+
+template <size_t N>
+Chunk<N> chunk() {
+    return {};
+}
+
+template <class F>
+ForEach<F> for_each(F f) {
+    return {std::move(f)};
+}
+
+template <class T, class Op = std::plus<>>
+Reduce<T, Op> reduce(T init, Op op = {}) {
+    return {std::move(init), std::move(op)};
+}
+
+inline ToVector to_vector(size_t reserve = 0) {
+    return {reserve};
+}
+
+template <Stage A, Stage B>
+Pipeline<A, B> operator|(A a, B b) {
+    return {{std::move(a), std::move(b)}};
+}
+
+template <Stage... Stages, Stage S>
+Pipeline<Stages..., S> operator|(Pipeline<Stages...> pipeline, S s) {
+    return {std::tuple_cat(std::move(pipeline.stages), std::tuple<S>(std::move(s)))};
+}
+
+template <std::ranges::viewable_range R, Stage S>
+auto operator|(R&& range, S s) {
+    return Bound<std::views::all_t<R>, S>{std::views::all(std::forward<R>(range)), {std::move(s)}};
+}
+
+template <std::ranges::viewable_range R, Stage... Stages>
+auto operator|(R&& range, Pipeline<Stages...> pipeline) {
+    return Bound<std::views::all_t<R>, Stages...>{std::views::all(std::forward<R>(range)), std::move(pipeline.stages)};
+}
+
+template <class V, class... Stages, Stage S>
+Bound<V, Stages..., S> operator|(Bound<V, Stages...> bound, S s) {
+    return {std::move(bound.range), std::tuple_cat(std::move(bound.stages), std::tuple<S>(std::move(s)))};
+}
+
+template <class V, class... Stages, class F>
+void operator|(Bound<V, Stages...> bound, ForEach<F> terminal) {
+    detail::Run(bound.range, bound.stages, [&]<class In>() { return terminal.template sink<In>(); });
+}
+
+template <class V, class... Stages, class T, class Op>
+T operator|(Bound<V, Stages...> bound, Reduce<T, Op> terminal) {
+    detail::Run(bound.range, bound.stages, [&]<class In>() { return terminal.template sink<In>(); });
+    return terminal.result();
+}
+
+template <class V, class... Stages>
+auto operator|(Bound<V, Stages...> bound, ToVector terminal) {
+    using Out = typename detail::OutputOf<std::ranges::range_reference_t<V>, Stages...>::type;
+    using Collector = ToVector::Collector<Out>;
+    Collector collector;
+    collector.values.reserve(terminal.reserve);
+    detail::Run(bound.range, bound.stages, [&]<class In>() { return typename Collector::Sink{&collector}; });
+    return std::move(collector.values);
+}
+
+} // namespace pipeline
+
+// transform_if.cpp as it is, over these two functions
+bool predicat(int x) {
+    return x % 3 != 0;
+}
+
+int func(int x) {
+    return x * x + 1;
+}
+
+#include "transform_if.cpp"
+
+template <class F>
+double Measure(F&& f) {
+    constexpr int iterations = 20;
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        f();
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+}
+
+int main() {
+    using namespace pipeline;
+
+    const std::vector<int> numbers { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14 };
+    const auto even = [](int x) { return x % 2 == 0; };
+    const auto half = [](int x) { return x / 2; };
+    for (int x : numbers | filter(even) | transform(half) | filter([](int x) { return x > 1; }) | take(3)
+                         | to_vector()) {
+        std::printf("%d ", x);
+    }
+    std::printf("\n");
+    numbers | chunk<4>() | for_each([](std::span<const int> part) {
+        std::printf("[%d..%d] ", part.front(), part.back());
+    });
+    std::printf("\n\n");
+
+    std::vector<int> v(1 << 22);
+    std::mt19937 gen(1);
+    for (auto& x : v) {
+        x = static_cast<int>(gen() % 1000);
+    }
+
+    std::vector<int> expected = transform_if(v);
+    const auto fused = v | transform_if(predicat, func) | to_vector(v.size());
+    auto viewed = v | std::views::filter(predicat) | std::views::transform(func);
+    if (fused != expected || !std::ranges::equal(viewed, expected)) {
+        std::printf("results differ\n");
+        return 1;
+    }
+
+    volatile long long sink;
+    std::printf("%-28s %10s %10s\n", "4M ints, ms", "vector", "sum");
+    std::printf("%-28s %10.2f %10.2f\n", "transform_if.cpp",
+                Measure([&] { sink = transform_if(v).size(); }),
+                Measure([&] {
+                    const auto result = transform_if(v);
+                    sink = std::accumulate(result.begin(), result.end(), 0ll);
+                }));
+    std::printf("%-28s %10.2f %10.2f\n", "std::views",
+                Measure([&] {
+                    std::vector<int> result;
+                    result.reserve(v.size());
+                    std::ranges::copy(v | std::views::filter(predicat) | std::views::transform(func),
+                                      std::back_inserter(result));
+                    sink = result.size();
+                }),
+                Measure([&] {
+                    long long sum = 0;
+                    for (int x : v | std::views::filter(predicat) | std::views::transform(func)) {
+                        sum += x;
+                    }
+                    sink = sum;
+                }));
+    std::printf("%-28s %10.2f %10.2f\n", "pipeline",
+                Measure([&] { sink = (v | transform_if(predicat, func) | to_vector(v.size())).size(); }),
+                Measure([&] { sink = v | transform_if(predicat, func) | reduce(0ll); }));
+}
@@ -0,0 +1,143 @@
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "transform.hpp"
+
+namespace {
+
+template <class F>
+double Measure(F&& f) {
+    const auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// p selects every 'period'-th element
+size_t period = 1;
+
+template <class T>
+bool Selected(const T& x);
+
+template <>
+bool Selected(const int& x) {
+    return static_cast<size_t>(x) % period == 0;
+}
+
+// The selector is the last character, which Transform doesn't change, so every iteration
+// selects the same strings
+template <>
+bool Selected(const std::string& s) {
+    return static_cast<size_t>(static_cast<unsigned char>(s.back())) % period == 0;
+}
+
+void Transform(int& x) {
+    x += static_cast<int>(period);
+}
+
+void Transform(std::string& s) {
+    s[0] = static_cast<char>(s[0] + period);
+}
+
+// What the undo log replaces: a copy of the whole range taken up front
+template <class T>
+void TransformIfFullCopy(T* begin, T* end, bool (*p)(const T&), void (*f)(T&)) {
+    std::vector<T> saved(begin, end);
+    try {
+        for (T* it = begin; it != end; ++it) {
+            if (p(*it)) {
+                f(*it);
+            }
+        }
+    } catch (...) {
+        std::copy(saved.begin(), saved.end(), begin);
+        throw;
+    }
+}
+
+template <class T>
+void Run(const char* type, std::vector<T> data, size_t selectivity) {
+    constexpr int iterations = 20;
+    period = 100 / selectivity;
+
+    bool (*p)(const T&) = Selected<T>;
+    void (*f)(T&) = Transform;
+
+    const double undoLog = Measure([&] {
+        for (int i = 0; i < iterations; ++i) {
+            TransformIf(data.data(), data.data() + data.size(), p, f);
+        }
+    });
+    size_t journalBytes = detail::LocalJournalArena().reserved();
+
+    const double fullCopy = Measure([&] {
+        for (int i = 0; i < iterations; ++i) {
+            TransformIfFullCopy(data.data(), data.data() + data.size(), p, f);
+        }
+    });
+    size_t copyBytes = data.size() * sizeof(T);
+    if constexpr (std::is_same_v<T, std::string>) {
+        // Saved strings own heap buffers as well
+        copyBytes += data.size() * (data.front().capacity() + 1);
+        journalBytes += data.size() / period * (data.front().capacity() + 1);
+    }
+
+    std::printf("%-8s %5zu%% %12.1f %12.1f %12zu %12zu\n", type, selectivity, undoLog / iterations,
+                fullCopy / iterations, journalBytes, copyBytes);
+}
+
+bool IsOdd(const int& x) {
+    return x % 2 != 0;
+}
+
+void Twice(int& x) {
+    x *= 2;
+}
+
+// Function pointers against inlinable lambdas, with and without the journal
+void RunCallables() {
+    constexpr size_t size = 1e7;
+    constexpr int iterations = 20;
+    std::vector<int> data(size);
+    for (size_t i = 0; i < size; ++i) {
+        data[i] = static_cast<int>(i);
+    }
+
+    auto run = [&](const char* name, auto p, auto f) {
+        const double time = Measure([&] {
+            for (int i = 0; i < iterations; ++i) {
+                TransformIf(data.data(), data.data() + data.size(), p, f);
+            }
+        });
+        std::printf("%-32s %12.2f\n", name, time / iterations);
+    };
+
+    std::printf("\n%-32s %12s\n", "callables, 1e7 ints", "ms");
+    run("function pointers", IsOdd, Twice);
+    run("lambdas", [](const int& x) { return x % 2 != 0; }, [](int& x) { x *= 2; });
+    run("noexcept lambdas", [](const int& x) noexcept { return x % 2 != 0; }, [](int& x) noexcept { x *= 2; });
+}
+
+} // namespace
+
+int main() {
+    constexpr size_t size = 1e6;
+    std::vector<int> ints(size);
+    std::vector<std::string> strings(size);
+    for (size_t i = 0; i < size; ++i) {
+        ints[i] = static_cast<int>(i);
+        strings[i] = "payload which does not fit into SSO " + std::string(1, static_cast<char>(i % 100));
+    }
+
+    // Every configuration runs in a fresh thread, so it starts with an empty journal arena
+    std::printf("%-8s %6s %12s %12s %12s %12s\n", "type", "p", "undo log, ms", "copy all, ms",
+                "journal, B", "copy, B");
+    for (size_t selectivity : { 1, 50, 100 }) {
+        std::thread(Run<int>, "int", ints, selectivity).join();
+        std::thread(Run<std::string>, "string", strings, selectivity).join();
+    }
+
+    RunCallables();
+}
@@ -1,5 +1,11 @@
 #include <gtest/gtest.h>
 
+#include <execution>
+#include <forward_list>
+#include <list>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
 #include <vector>
 #include <string>
 
@@ -237,6 +243,8 @@ TEST(Stress, stress) {
     constexpr int len = 1e6;
     constexpr int iterations = 1e4;
 
+    // Int can't be moved, so growing the vector would copy it and hit the copy counter
+    data.reserve(len);
     for (int i = 0; i < len; ++i) {
         data.emplace_back(i);
     }
@@ -250,3 +258,246 @@ TEST(Stress, stress) {
         }
     }
 }
+
+namespace parallel {
+bool p(const std::string& s) {
+    return s.size() % 2 == 0;
+}
+
+void f(std::string& s) {
+    if (s == "stop") {
+        throw std::runtime_error("Stop");
+    }
+    s += "!";
+}
+}
+
+TEST(Parallel, works) {
+    std::vector<std::string> data;
+    for (int i = 0; i < 100000; ++i) {
+        data.push_back(std::string(i % 5, 'a'));
+    }
+    auto expected = data;
+    for (auto& s : expected) {
+        if (parallel::p(s)) {
+            parallel::f(s);
+        }
+    }
+
+    auto copy = data;
+    TransformIf(std::execution::par, copy.data(), copy.data() + copy.size(), parallel::p, parallel::f);
+    ASSERT_EQ(copy, expected);
+
+    for (size_t parts : { 1, 2, 3, 8, 16 }) {
+        auto copy = data;
+        detail::TransformIfParallel(copy.data(), copy.data() + copy.size(), parallel::p, parallel::f, parts);
+        ASSERT_EQ(copy, expected);
+    }
+}
+
+TEST(Parallel, rollback) {
+    std::vector<std::string> data;
+    for (int i = 0; i < 100000; ++i) {
+        data.push_back(std::string(i % 5, 'a'));
+    }
+
+    // The failing element is in different pieces depending on the split
+    for (size_t position : { size_t(0), data.size() / 3, data.size() - 1 }) {
+        auto copy = data;
+        copy[position] = "stop";
+        const auto expected = copy;
+        for (size_t parts : { 2, 3, 8, 16 }) {
+            ASSERT_THROW(detail::TransformIfParallel(copy.data(), copy.data() + copy.size(),
+                                                     parallel::p, parallel::f, parts),
+                         std::runtime_error);
+            ASSERT_EQ(copy, expected);
+        }
+        ASSERT_THROW(TransformIf(std::execution::par, copy.data(), copy.data() + copy.size(),
+                                 parallel::p, parallel::f),
+                     std::runtime_error);
+        ASSERT_EQ(copy, expected);
+    }
+}
+
+namespace sparse {
+bool p(const int& x) {
+    return x % 100 == 0;
+}
+
+void f(int& x) {
+    ++x;
+}
+}
+
+TEST(Parallel, reusesThreads) {
+    std::vector<int> data(100000);
+    detail::TransformIfParallel(data.data(), data.data() + data.size(), sparse::p, sparse::f, 4);
+    const size_t threads = detail::WorkerPool::Instance().size();
+    ASSERT_GE(threads, 3u);
+    for (int i = 0; i < 10; ++i) {
+        detail::TransformIfParallel(data.data(), data.data() + data.size(), sparse::p, sparse::f, 4);
+    }
+    ASSERT_EQ(threads, detail::WorkerPool::Instance().size());
+    // Only the first call selects the zeros
+    ASSERT_EQ(std::vector<int>(data.size(), 1), data);
+}
+
+TEST(UndoLog, sparse) {
+    std::vector<int> data(100000);
+    std::iota(data.begin(), data.end(), 0);
+
+    // The arena is thread local and earlier tests have grown the one of this thread,
+    // a new thread starts with an empty arena
+    std::thread([&] {
+        TransformIf(data.data(), data.data() + data.size(), sparse::p, sparse::f);
+        const size_t reserved = detail::LocalJournalArena().reserved();
+        // Only every hundredth element is journaled
+        ASSERT_LT(reserved, data.size() * sizeof(int) / 10);
+
+        // The arena is reused by the next call
+        TransformIf(data.data(), data.data() + data.size(), sparse::p, sparse::f);
+        ASSERT_EQ(reserved, detail::LocalJournalArena().reserved());
+    }).join();
+    ASSERT_EQ(1, data[0]);
+    ASSERT_EQ(101, data[100]);
+}
+
+TEST(UndoLog, overAligned) {
+    struct alignas(64) Wide {
+        int value;
+    };
+
+    detail::JournalArena arena;
+    for (size_t align : { 1, 8, 32, 64, 128 }) {
+        arena.allocate(1, 1);
+        ASSERT_EQ(0u, reinterpret_cast<uintptr_t>(arena.allocate(8, align)) % align);
+    }
+
+    std::vector<Wide> data(1000);
+    for (int i = 0; i < 1000; ++i) {
+        data[i].value = i;
+    }
+    ASSERT_THROW(TransformIf(data.begin(), data.end(), [](const Wide& x) { return x.value % 3 == 0; },
+                             [](Wide& x) {
+                                 if (x.value == 900) {
+                                     throw std::runtime_error("fail");
+                                 }
+                                 x.value = -1;
+                             }),
+                 std::runtime_error);
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_EQ(i, data[i].value);
+    }
+}
+
+TEST(Generic, lambdas) {
+    std::list<std::string> words{"cpp", "is", "very", "cool"};
+    const size_t minSize = 3;
+    int calls = 0;
+    TransformIf(words.begin(), words.end(),
+                [&](const std::string& s) { return s.size() >= minSize; },
+                [&](std::string& s) { s += "!"; ++calls; });
+    std::list<std::string> expected{"cpp!", "is", "very!", "cool!"};
+    ASSERT_EQ(words, expected);
+    ASSERT_EQ(3, calls);
+
+    std::forward_list<int> numbers{1, 2, 3, 4};
+    TransformIf(numbers.begin(), numbers.end(),
+                [](int x) noexcept { return x % 2 == 0; },
+                [](int& x) noexcept { x *= 10; });
+    std::forward_list<int> expectedNumbers{1, 20, 3, 40};
+    ASSERT_EQ(numbers, expectedNumbers);
+}
+
+TEST(Generic, rollback) {
+    std::list<std::string> words{"cpp", "is", "very", "cool"};
+    const auto expected = words;
+    ASSERT_THROW(TransformIf(words.begin(), words.end(),
+                             [](const std::string&) { return true; },
+                             [](std::string& s) {
+                                 if (s == "cool") {
+                                     throw std::runtime_error("too cool");
+                                 }
+                                 s.clear();
+                             }),
+                 std::runtime_error);
+    ASSERT_EQ(words, expected);
+}
+
+TEST(Generic, nothrow) {
+    std::vector<int> data(1000);
+    std::iota(data.begin(), data.end(), 0);
+    const int factor = 3;
+    TransformIf(data.begin(), data.end(),
+                [](int x) noexcept { return x % 2 != 0; },
+                [factor](int& x) noexcept { x *= factor; });
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_EQ(i % 2 != 0 ? i * factor : i, data[i]);
+    }
+
+    TransformIf(std::execution::par, data.begin(), data.end(),
+                [](int x) noexcept { return x % 2 == 0; },
+                [](int& x) noexcept { x = -x; });
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_EQ(i % 2 != 0 ? i * factor : -i, data[i]);
+    }
+}
+
+TEST(Generic, nothrowSeesElements) {
+    std::vector<int> data(100, 1);
+    size_t selected = 0;
+    TransformIf(data.begin(), data.end(),
+                [&](const int& x) noexcept {
+                    // p gets the element itself, not a copy
+                    EXPECT_EQ(&data[selected], &x);
+                    return ++selected % 2 == 0;
+                },
+                [](int& x) noexcept { ++x; });
+    for (size_t i = 0; i < data.size(); ++i) {
+        ASSERT_EQ(i % 2 != 0 ? 2 : 1, data[i]);
+    }
+}
+
+static_assert(detail::ChooseJournalStrategy<int*>() == detail::JournalStrategy::Memcpy);
+static_assert(detail::ChooseJournalStrategy<std::string*>() == detail::JournalStrategy::Move);
+static_assert(detail::ChooseJournalStrategy<std::list<std::string>::iterator>() == detail::JournalStrategy::Move);
+static_assert(detail::ChooseJournalStrategy<Int*>() == detail::JournalStrategy::Copy);
+
+struct Payload {
+    static inline int copies = 0;
+
+    std::string data;
+
+    Payload(std::string data) : data(std::move(data)) { }
+    Payload(const Payload& rhs) : data(rhs.data) {
+        ++copies;
+    }
+    Payload(Payload&&) noexcept = default;
+    Payload& operator=(const Payload& rhs) {
+        ++copies;
+        data = rhs.data;
+        return *this;
+    }
+    Payload& operator=(Payload&&) noexcept = default;
+
+    bool operator==(const Payload&) const = default;
+};
+
+TEST(Strategy, moveBack) {
+    std::vector<Payload> data{Payload("a"), Payload("b"), Payload("c"), Payload("d")};
+    const auto expected = data;
+
+    Payload::copies = 0;
+    ASSERT_THROW(TransformIf(data.begin(), data.end(),
+                             [](const Payload&) { return true; },
+                             [](Payload& p) {
+                                 if (p.data == "d") {
+                                     throw std::runtime_error("d");
+                                 }
+                                 p.data += p.data;
+                             }),
+                 std::runtime_error);
+    ASSERT_EQ(data, expected);
+    // One copy per saved element, restoring moves them back
+    ASSERT_EQ(4, Payload::copies);
+}
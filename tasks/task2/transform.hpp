@@ -1,4 +1,462 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <barrier>
+#include <concepts>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <exception>
+#include <execution>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace detail {
+
+// Bump allocator for undo logs. It is thread-local and keeps its memory between calls,
+// so a journal costs no system allocations once the arena has grown.
+// Journals release memory in LIFO order, which makes nested TransformIf calls safe.
+class JournalArena {
+public:
+    struct Mark {
+        size_t block;
+        size_t offset;
+    };
+
+    Mark mark() const {
+        return {current_, offset_};
+    }
+
+    void release(Mark mark) {
+        current_ = mark.block;
+        offset_ = mark.offset;
+    }
+
+    // Blocks are only aligned for new[], so the address itself is aligned, not the offset
+    void* allocate(size_t size, size_t align) {
+        while (current_ < blocks_.size()) {
+            std::byte* data = blocks_[current_].data.get();
+            void* ptr = data + offset_;
+            size_t space = blocks_[current_].size - offset_;
+            if (std::align(align, size, ptr, space) != nullptr) {
+                offset_ = static_cast<std::byte*>(ptr) - data + size;
+                return ptr;
+            }
+            ++current_;
+            offset_ = 0;
+        }
+
+        const size_t blockSize = std::max(size + align, blocks_.empty() ? firstBlockSize : 2 * blocks_.back().size);
+        blocks_.push_back({std::make_unique<std::byte[]>(blockSize), blockSize});
+        current_ = blocks_.size() - 1;
+        offset_ = 0;
+        return allocate(size, align);
+    }
+
+    size_t reserved() const {
+        size_t total = 0;
+        for (const auto& block : blocks_) {
+            total += block.size;
+        }
+        return total;
+    }
+
+private:
+    struct Block {
+        std::unique_ptr<std::byte[]> data;
+        size_t size;
+    };
+
+    static constexpr size_t firstBlockSize = 1 << 12;
+
+    std::vector<Block> blocks_;
+    size_t current_ = 0;
+    size_t offset_ = 0;
+};
+
+inline JournalArena& LocalJournalArena() {
+    thread_local JournalArena arena;
+    return arena;
+}
+
+// How the journal saves and restores elements, the cheapest option the type allows
+enum class JournalStrategy {
+    Memcpy, // trivially copyable: bytes in and out, nothing can throw
+    Move,   // copy in, nothrow move assignment back
+    Swap,   // copy in, nothrow swap back
+    Copy,   // copy in, copy assignment back, failures are swallowed
+};
+
+template <class It>
+constexpr JournalStrategy ChooseJournalStrategy() {
+    using T = std::iter_value_t<It>;
+    if constexpr (std::is_trivially_copyable_v<T> && std::is_lvalue_reference_v<std::iter_reference_t<It>>) {
+        return JournalStrategy::Memcpy;
+    } else if constexpr (std::is_nothrow_move_assignable_v<T>) {
+        return JournalStrategy::Move;
+    } else if constexpr (std::is_nothrow_swappable_v<T>) {
+        return JournalStrategy::Swap;
+    } else {
+        return JournalStrategy::Copy;
+    }
+}
+
+// Undo log of TransformIf: (element, saved value) entries are written only for
+// the elements p selected, so its size depends on the number of changes, not on the range.
+template <class It>
+class TransformJournal {
+public:
+    using T = std::iter_value_t<It>;
+
+    static constexpr JournalStrategy strategy = ChooseJournalStrategy<It>();
+
+    TransformJournal() : arena_(LocalJournalArena()), mark_(arena_.mark()) { }
+
+    TransformJournal(const TransformJournal&) = delete;
+    TransformJournal& operator=(const TransformJournal&) = delete;
+
+    ~TransformJournal() {
+        while (last_ != nullptr) {
+            Entry* prev = last_->prev;
+            if constexpr (strategy != JournalStrategy::Memcpy) {
+                last_->saved()->~T();
+            }
+            last_->~Entry();
+            last_ = prev;
+        }
+        arena_.release(mark_);
+    }
+
+    // Saves a copy of '*item'. If copying fails the item is left out of the journal:
+    // p and f may still succeed, and then the copy is not needed at all.
+    void save(const It& item) {
+        try {
+            auto* entry = new (arena_.allocate(sizeof(Entry), alignof(Entry))) Entry(last_, item);
+            if constexpr (strategy == JournalStrategy::Memcpy) {
+                std::memcpy(entry->storage, std::addressof(*item), sizeof(T));
+            } else {
+                try {
+                    new (entry->storage) T(*item);
+                } catch (...) {
+                    entry->~Entry();
+                    throw;
+                }
+            }
+            last_ = entry;
+            ++size_;
+        } catch (...) {
+        }
+    }
+
+    // Restores saved elements. The original exception is rethrown by the caller,
+    // so failures during restoring are swallowed, the sequence is unspecified then anyway.
+    void rollback() noexcept {
+        for (Entry* entry = last_; entry != nullptr; entry = entry->prev) {
+            if constexpr (strategy == JournalStrategy::Memcpy) {
+                std::memcpy(std::addressof(*entry->item), entry->storage, sizeof(T));
+            } else if constexpr (strategy == JournalStrategy::Move) {
+                *entry->item = std::move(*entry->saved());
+            } else if constexpr (strategy == JournalStrategy::Swap) {
+                using std::swap;
+                swap(*entry->item, *entry->saved());
+            } else {
+                try {
+                    *entry->item = *entry->saved();
+                } catch (...) {
+                }
+            }
+        }
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+private:
+    // Entries live in the arena and are linked backwards, the order rollback needs.
+    // They are never relocated, so T doesn't have to be movable.
+    struct Entry {
+        Entry(Entry* prev, const It& item) : prev(prev), item(item) { }
+
+        Entry* prev;
+        It item;
+        alignas(T) std::byte storage[sizeof(T)];
+
+        T* saved() {
+            return std::launder(reinterpret_cast<T*>(storage));
+        }
+    };
+
+    JournalArena& arena_;
+    JournalArena::Mark mark_;
+    Entry* last_ = nullptr;
+    size_t size_ = 0;
+};
+
+// If neither p nor f can throw, there is nothing to roll back
+template <class It, class P, class F>
+constexpr bool NothrowTransform = std::is_nothrow_invocable_v<P&, std::iter_reference_t<It>>
+                                  && std::is_nothrow_invocable_v<F&, std::iter_reference_t<It>>;
+
+template <class It, class S, class P, class F>
+void TransformIfJournaled(It begin, S end, P& p, F& f, TransformJournal<It>& journal,
+                          const std::atomic<bool>* stop = nullptr) {
+    for (It it = begin; it != end; ++it) {
+        if (stop != nullptr && stop->load(std::memory_order_relaxed)) {
+            return;
+        }
+        if (p(*it)) {
+            journal.save(it);
+            f(*it);
+        }
+    }
+}
+
+// p and f see the elements themselves and only selected elements are stored. For contiguous
+// ranges and simple callables the compiler still vectorizes the loop with masked stores.
+template <class It, class S, class P, class F>
+void TransformIfNothrow(It begin, S end, P& p, F& f) noexcept {
+    for (It it = begin; it != end; ++it) {
+        if (p(*it)) {
+            f(*it);
+        }
+    }
+}
+
+} // namespace detail
+
+// Accepts any callables and any forward range. p gets the element as an lvalue
+// and must not change it.
+template <std::forward_iterator It, std::sentinel_for<It> S, class P, class F>
+    requires std::predicate<P&, std::iter_reference_t<It>> && std::invocable<F&, std::iter_reference_t<It>>
+void TransformIf(It begin, S end, P p, F f) {
+    if constexpr (detail::NothrowTransform<It, P, F>) {
+        detail::TransformIfNothrow(begin, end, p, f);
+    } else {
+        detail::TransformJournal<It> journal;
+        try {
+            detail::TransformIfJournaled(begin, end, p, f, journal);
+        } catch (...) {
+            journal.rollback();
+            throw;
+        }
+    }
+}
+
 template <class T>
 void TransformIf(T* begin, T* end, bool (*p)(const T&), void (*f)(T&)) {
-    // Your code goes here
+    TransformIf<T*, T*>(begin, end, p, f);
+}
+
+namespace detail {
+
+// Threads kept between parallel calls. A call takes idle threads and starts new ones only
+// when none are idle, so the parts of one call always run at the same time, as the barrier
+// in TransformIfParallel needs, and nested or concurrent calls never wait for each other.
+class WorkerPool {
+public:
+    class Worker {
+    public:
+        Worker() : thread_([this] { loop(); }) { }
+
+        ~Worker() {
+            {
+                std::lock_guard lock(mutex_);
+                stop_ = true;
+            }
+            ready_.notify_all();
+            thread_.join();
+        }
+
+        void start(const std::function<void(size_t)>* task, size_t part) {
+            {
+                std::lock_guard lock(mutex_);
+                task_ = task;
+                part_ = part;
+            }
+            ready_.notify_all();
+        }
+
+        void wait() {
+            std::unique_lock lock(mutex_);
+            ready_.wait(lock, [this] { return task_ == nullptr; });
+        }
+
+    private:
+        std::mutex mutex_;
+        std::condition_variable ready_;
+        const std::function<void(size_t)>* task_ = nullptr;
+        size_t part_ = 0;
+        bool stop_ = false;
+        // Last, the thread starts after the other members are initialized
+        std::thread thread_;
+
+        void loop() {
+            std::unique_lock lock(mutex_);
+            while (true) {
+                ready_.wait(lock, [this] { return stop_ || task_ != nullptr; });
+                if (task_ == nullptr) {
+                    return;
+                }
+                lock.unlock();
+                (*task_)(part_);
+                lock.lock();
+                task_ = nullptr;
+                ready_.notify_all();
+            }
+        }
+    };
+
+    // Up to 'count' workers of the pool, fewer if no more threads can be started.
+    // The workers return to the pool when the team is destroyed.
+    class Team {
+    public:
+        Team(WorkerPool& pool, size_t count) : pool_(pool), workers_(pool.acquire(count)) { }
+
+        Team(const Team&) = delete;
+        Team& operator=(const Team&) = delete;
+
+        ~Team() {
+            for (size_t i = 0; i < started_; ++i) {
+                workers_[i]->wait();
+            }
+            pool_.release(workers_);
+        }
+
+        size_t size() const {
+            return workers_.size();
+        }
+
+        // Calls task(1) .. task(size()) on the workers and task(0) on this thread,
+        // returns when all of them have finished. The task must not throw.
+        void run(const std::function<void(size_t)>& task) {
+            for (; started_ < workers_.size(); ++started_) {
+                workers_[started_]->start(&task, started_ + 1);
+            }
+            task(0);
+            for (; started_ > 0; --started_) {
+                workers_[started_ - 1]->wait();
+            }
+        }
+
+    private:
+        WorkerPool& pool_;
+        std::vector<Worker*> workers_;
+        size_t started_ = 0;
+    };
+
+    static WorkerPool& Instance() {
+        static WorkerPool pool;
+        return pool;
+    }
+
+    // Threads started so far
+    size_t size() {
+        std::lock_guard lock(mutex_);
+        return workers_.size();
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<Worker*> idle_;
+
+    std::vector<Worker*> acquire(size_t count) {
+        std::vector<Worker*> team;
+        team.reserve(count);
+        std::lock_guard lock(mutex_);
+        while (team.size() < count) {
+            if (idle_.empty()) {
+                try {
+                    workers_.reserve(workers_.size() + 1);
+                    idle_.reserve(workers_.size() + 1);
+                    workers_.push_back(std::make_unique<Worker>());
+                } catch (...) {
+                    // Out of threads or memory, the call runs in fewer parts
+                    break;
+                }
+                idle_.push_back(workers_.back().get());
+            }
+            team.push_back(idle_.back());
+            idle_.pop_back();
+        }
+        return team;
+    }
+
+    void release(const std::vector<Worker*>& team) {
+        std::lock_guard lock(mutex_);
+        idle_.insert(idle_.end(), team.begin(), team.end());
+    }
+};
+
+// The range is split into at most 'parts' pieces processed by threads of the pool, each keeping
+// its own journal. If p or f throws in any worker, the others stop, every worker rolls back
+// its piece, and the first exception is rethrown.
+template <class It, class P, class F>
+void TransformIfParallel(It begin, It end, P p, F f, size_t parts) {
+    WorkerPool::Team team(WorkerPool::Instance(), parts - 1);
+    // The barrier counts the threads actually obtained, a thread that failed to start
+    // would leave the others waiting forever
+    parts = team.size() + 1;
+
+    const auto size = end - begin;
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+    std::mutex errorMutex;
+    std::barrier sync(static_cast<std::ptrdiff_t>(parts));
+
+    team.run([&](size_t part) {
+        It partBegin = begin + size * part / parts;
+        It partEnd = begin + size * (part + 1) / parts;
+        if constexpr (NothrowTransform<It, P, F>) {
+            TransformIfNothrow(partBegin, partEnd, p, f);
+        } else {
+            TransformJournal<It> journal;
+            try {
+                TransformIfJournaled(partBegin, partEnd, p, f, journal, &failed);
+            } catch (...) {
+                std::lock_guard lock(errorMutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+                failed.store(true, std::memory_order_relaxed);
+            }
+            // Nobody may touch the range after this point unless rolling back
+            sync.arrive_and_wait();
+            if (failed.load(std::memory_order_relaxed)) {
+                journal.rollback();
+            }
+        }
+    });
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+} // namespace detail
+
+// Same guarantees as the sequential version, the range is processed by several threads
+// unless the policy is std::execution::seq. p and f must be safe to call concurrently.
+template <class ExecutionPolicy, std::random_access_iterator It, class P, class F>
+    requires std::is_execution_policy_v<std::remove_cvref_t<ExecutionPolicy>>
+             && std::predicate<P&, std::iter_reference_t<It>> && std::invocable<F&, std::iter_reference_t<It>>
+void TransformIf(ExecutionPolicy&&, It begin, It end, P p, F f) {
+    constexpr size_t minPartSize = 1 << 14;
+    const size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+    const size_t parts = std::min(hardware, (static_cast<size_t>(end - begin) + minPartSize - 1) / minPartSize);
+
+    if (std::is_same_v<std::remove_cvref_t<ExecutionPolicy>, std::execution::sequenced_policy> || parts <= 1) {
+        TransformIf(begin, end, p, f);
+    } else {
+        detail::TransformIfParallel(begin, end, p, f, parts);
+    }
 }
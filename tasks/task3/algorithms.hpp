@@ -0,0 +1,142 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <ranges>
+#include <thread>
+#include <vector>
+
+#include "indexed_iterator.hpp"
+
+// Parallel index reductions over sized random access ranges.
+// The range is split into contiguous parts, each thread reduces its part with IndexedIterator
+// and the (index, value) results are merged in part order, so the answer doesn't depend on
+// the number of threads. 'threads' = 0 means std::thread::hardware_concurrency().
+// A range without a matching element gives std::ranges::size(range).
+// An exception thrown by a comparison or a predicate is rethrown in the calling thread once
+// all parts have finished, the first one in part order if several parts throw.
+
+namespace detail {
+
+constexpr size_t minParallelPart = 1 << 15;
+
+inline size_t ParallelParts(size_t size, size_t threads) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    return std::max<size_t>(1, std::min(threads, size / minParallelPart));
+}
+
+// Calls work(part, begin, end) for every part, the first part runs in the calling thread.
+// An exception escaping a jthread would call std::terminate, so each part catches its own.
+template <class Work>
+void ForEachPart(size_t size, size_t parts, Work& work) {
+    std::vector<std::exception_ptr> errors(parts);
+    auto guarded = [&](size_t part) {
+        try {
+            work(part, size * part / parts, size * (part + 1) / parts);
+        } catch (...) {
+            errors[part] = std::current_exception();
+        }
+    };
+    {
+        std::vector<std::jthread> workers;
+        workers.reserve(parts - 1);
+        for (size_t part = 1; part < parts; ++part) {
+            workers.emplace_back(guarded, part);
+        }
+        guarded(0);
+    }
+    for (auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+// First element of the range for which no later element is better according to 'better'
+template <std::ranges::random_access_range R, class Better>
+    requires std::ranges::sized_range<R>
+size_t ParallelArgBest(R&& range, Better better, size_t threads) {
+    const size_t size = std::ranges::size(range);
+    if (size == 0) {
+        return 0;
+    }
+    const size_t parts = ParallelParts(size, threads);
+    const auto first = CreateIndexedIterator(std::ranges::begin(range));
+    std::vector<size_t> best(parts);
+
+    auto work = [&](size_t part, size_t begin, size_t end) {
+        // std::max_element semantics: the first of equal elements wins
+        auto it = first + begin;
+        auto result = it;
+        for (++it; it.index() < end; ++it) {
+            if (better(*it, *result)) {
+                result = it;
+            }
+        }
+        best[part] = result.index();
+    };
+    ForEachPart(size, parts, work);
+
+    size_t result = best[0];
+    for (size_t part = 1; part < parts; ++part) {
+        if (better(first[best[part]], first[result])) {
+            result = best[part];
+        }
+    }
+    return result;
+}
+
+} // namespace detail
+
+// Index of the first greatest element, like std::max_element
+template <std::ranges::random_access_range R, class Compare = std::ranges::less>
+    requires std::ranges::sized_range<R>
+size_t ParallelArgMax(R&& range, Compare comp = {}, size_t threads = 0) {
+    return detail::ParallelArgBest(range, [&](const auto& lhs, const auto& rhs) {
+        return std::invoke(comp, rhs, lhs);
+    }, threads);
+}
+
+// Index of the first smallest element, like std::min_element
+template <std::ranges::random_access_range R, class Compare = std::ranges::less>
+    requires std::ranges::sized_range<R>
+size_t ParallelArgMin(R&& range, Compare comp = {}, size_t threads = 0) {
+    return detail::ParallelArgBest(range, [&](const auto& lhs, const auto& rhs) {
+        return std::invoke(comp, lhs, rhs);
+    }, threads);
+}
+
+// Index of the first element satisfying 'pred'. Parts stop scanning once a match
+// has been found before them.
+template <std::ranges::random_access_range R, class Pred>
+    requires std::ranges::sized_range<R>
+size_t ParallelFindFirstIndex(R&& range, Pred pred, size_t threads = 0) {
+    const size_t size = std::ranges::size(range);
+    const size_t parts = detail::ParallelParts(size, threads);
+    const auto first = CreateIndexedIterator(std::ranges::begin(range));
+    std::atomic<size_t> found{size};
+
+    auto work = [&](size_t, size_t begin, size_t end) {
+        constexpr size_t checkEvery = 1024;
+        for (auto it = first + begin; it.index() < end; ++it) {
+            if (it.index() % checkEvery == 0 && found.load(std::memory_order_relaxed) < begin) {
+                return;
+            }
+            if (std::invoke(pred, *it)) {
+                size_t current = found.load(std::memory_order_relaxed);
+                while (it.index() < current && !found.compare_exchange_weak(current, it.index())) {
+                }
+                return;
+            }
+        }
+    };
+    detail::ForEachPart(size, parts, work);
+
+    return found.load();
+}
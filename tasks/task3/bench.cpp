@@ -0,0 +1,125 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include "algorithms.hpp"
+#include "indexed_iterator.hpp"
+#include "min_max.hpp"
+
+namespace {
+
+template <class F>
+double Measure(F&& f) {
+    constexpr int iterations = 20;
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        f();
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+}
+
+volatile size_t sink;
+
+void Report(const char* name, double raw, double indexed) {
+    std::printf("%-24s %10.2f %10.2f %8.2fx\n", name, raw, indexed, indexed / raw);
+}
+
+// Walks a map without reading index() on the way, optionally reads it at the end
+template <class IndexPolicy>
+double WalkMap(const std::map<int, int>& m, bool readIndex) {
+    return Measure([&] {
+        long long sum = 0;
+        auto it = CreateIndexedIterator(m.begin(), 0, IndexPolicy{});
+        for (; it != m.end(); ++it) {
+            sum += it->second;
+        }
+        sink = sum + (readIndex ? it.index() : 0);
+    });
+}
+
+void RunMap(size_t size) {
+    std::map<int, int> m;
+    for (size_t i = 0; i < size; ++i) {
+        m.emplace_hint(m.end(), static_cast<int>(i), static_cast<int>(i));
+    }
+
+    const double raw = Measure([&] {
+        long long sum = 0;
+        for (const auto& [key, value] : m) {
+            sum += value;
+        }
+        sink = sum;
+    });
+    std::printf("\n%-24s %10s %10s %10s %12s\n", "std::map walk, ms", "raw", "eager", "lazy",
+                "lazy+index");
+    std::printf("%-24zu %10.2f %10.2f %10.2f %12.2f\n", size, raw, WalkMap<EagerIndex>(m, true),
+                WalkMap<LazyIndex>(m, false), WalkMap<LazyIndex>(m, true));
+}
+
+// std::max_element against the SIMD MaxElement on the same IndexedIterator range
+template <class T>
+void RunMinMax(const char* name, size_t size) {
+    std::vector<T> v(size);
+    for (size_t i = 0; i < size; ++i) {
+        v[i] = static_cast<T>((i * 7919) % 1000003);
+    }
+    const auto first = CreateIndexedIterator(v.begin());
+    const auto last = CreateIndexedIterator(v.end(), size);
+    Report(name,
+           Measure([&] { sink = std::max_element(first, last).index(); }),
+           Measure([&] { sink = MaxElement(first, last).index(); }));
+}
+
+void RunParallel(const std::vector<int>& v) {
+    std::printf("\n%-24s %10s %10s %10s\n", "1e7 ints, ms", "argmax", "argmin", "find");
+    const size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+    for (size_t threads = 1; threads <= hardware; threads *= 2) {
+        std::printf("%-24zu %10.2f %10.2f %10.2f\n", threads,
+                    Measure([&] { sink = ParallelArgMax(v, std::ranges::less{}, threads); }),
+                    Measure([&] { sink = ParallelArgMin(v, std::ranges::less{}, threads); }),
+                    Measure([&] { sink = ParallelFindFirstIndex(v, [](int x) { return x < 0; }, threads); }));
+    }
+}
+
+} // namespace
+
+// Usage: task3_bench [map-size], the map walk uses 1e7 nodes by default
+int main(int argc, char** argv) {
+    constexpr size_t size = 1e7;
+    std::vector<int> v(size);
+    std::iota(v.begin(), v.end(), 0);
+    std::vector<int> out(size);
+
+    const auto first = CreateIndexedIterator(v.begin());
+    const auto last = CreateIndexedIterator(v.end(), size);
+
+    std::printf("%-24s %10s %10s %9s\n", "1e7 ints, ms", "raw", "indexed", "ratio");
+    Report("std::find",
+           Measure([&] { sink = std::find(v.begin(), v.end(), -1) - v.begin(); }),
+           Measure([&] { sink = std::find(first, last, -1).index(); }));
+    Report("std::max_element",
+           Measure([&] { sink = std::max_element(v.begin(), v.end()) - v.begin(); }),
+           Measure([&] { sink = std::max_element(first, last).index(); }));
+    Report("std::copy",
+           Measure([&] { sink = std::copy(v.begin(), v.end(), out.begin()) - out.begin(); }),
+           Measure([&] { sink = std::copy(first, last, out.begin()) - out.begin(); }));
+    Report("std::ranges::copy",
+           Measure([&] { sink = std::ranges::copy(v, out.begin()).out - out.begin(); }),
+           Measure([&] { sink = std::ranges::copy(first, last, out.begin()).out - out.begin(); }));
+    Report("std::ranges::max_element",
+           Measure([&] { sink = std::ranges::max_element(v) - v.begin(); }),
+           Measure([&] { sink = std::ranges::max_element(first, last).index(); }));
+
+    std::printf("\n%-24s %10s %10s %9s\n", "1e7 elements, ms", "std", "MaxElement", "ratio");
+    RunMinMax<int>("int", size);
+    RunMinMax<float>("float", size);
+    RunMinMax<double>("double", size);
+
+    RunParallel(v);
+    RunMap(argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000);
+}
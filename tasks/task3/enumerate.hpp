@@ -0,0 +1,211 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <ranges>
+#include <type_traits>
+#include <utility>
+
+#include "indexed_iterator.hpp"
+
+// View of (index, element) pairs over another view, built on IndexedIterator.
+// Elements are returned as std::pair<size_t, reference>, so writes through 'second'
+// reach the underlying range:
+//     for (auto [i, x] : v | Enumerate) { x += i; }
+template <std::ranges::view V>
+    requires std::ranges::input_range<V>
+class EnumerateView : public std::ranges::view_interface<EnumerateView<V>> {
+    using BaseIterator = std::ranges::iterator_t<V>;
+    using BaseSentinel = std::ranges::sentinel_t<V>;
+
+public:
+    class Iterator {
+    public:
+        using iterator_concept = std::conditional_t<std::ranges::random_access_range<V>, std::random_access_iterator_tag,
+                                 std::conditional_t<std::ranges::bidirectional_range<V>, std::bidirectional_iterator_tag,
+                                 std::conditional_t<std::ranges::forward_range<V>, std::forward_iterator_tag,
+                                                    std::input_iterator_tag>>>;
+        using value_type = std::pair<size_t, std::ranges::range_value_t<V>>;
+        using reference = std::pair<size_t, std::ranges::range_reference_t<V>>;
+        using difference_type = std::ranges::range_difference_t<V>;
+
+        Iterator() = default;
+
+        Iterator(BaseIterator it, size_t index) : it_(std::move(it), index) { }
+
+        size_t index() const {
+            return it_.index();
+        }
+
+        const BaseIterator& base() const {
+            return it_.base();
+        }
+
+        reference operator*() const {
+            return {it_.index(), *it_};
+        }
+
+        reference operator[](difference_type n) const
+            requires std::ranges::random_access_range<V>
+        {
+            return *(*this + n);
+        }
+
+        Iterator& operator++() {
+            ++it_;
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator copy = *this;
+            ++*this;
+            return copy;
+        }
+
+        Iterator& operator--()
+            requires std::ranges::bidirectional_range<V>
+        {
+            --it_;
+            return *this;
+        }
+
+        Iterator operator--(int)
+            requires std::ranges::bidirectional_range<V>
+        {
+            Iterator copy = *this;
+            --*this;
+            return copy;
+        }
+
+        Iterator& operator+=(difference_type n)
+            requires std::ranges::random_access_range<V>
+        {
+            it_ += n;
+            return *this;
+        }
+
+        Iterator& operator-=(difference_type n)
+            requires std::ranges::random_access_range<V>
+        {
+            it_ -= n;
+            return *this;
+        }
+
+        friend Iterator operator+(Iterator it, difference_type n)
+            requires std::ranges::random_access_range<V>
+        {
+            return it += n;
+        }
+
+        friend Iterator operator+(difference_type n, Iterator it)
+            requires std::ranges::random_access_range<V>
+        {
+            return it += n;
+        }
+
+        friend Iterator operator-(Iterator it, difference_type n)
+            requires std::ranges::random_access_range<V>
+        {
+            return it -= n;
+        }
+
+        friend difference_type operator-(const Iterator& lhs, const Iterator& rhs)
+            requires std::sized_sentinel_for<BaseIterator, BaseIterator>
+        {
+            return lhs.it_ - rhs.it_;
+        }
+
+        friend bool operator==(const Iterator& lhs, const Iterator& rhs)
+            requires std::equality_comparable<BaseIterator>
+        {
+            return lhs.it_ == rhs.it_;
+        }
+
+        friend auto operator<=>(const Iterator& lhs, const Iterator& rhs)
+            requires std::ranges::random_access_range<V> && std::three_way_comparable<BaseIterator>
+        {
+            return lhs.it_ <=> rhs.it_;
+        }
+
+    private:
+        IndexedIterator<BaseIterator> it_;
+    };
+
+    class Sentinel {
+    public:
+        Sentinel() = default;
+
+        explicit Sentinel(BaseSentinel end) : end_(std::move(end)) { }
+
+        friend bool operator==(const Iterator& it, const Sentinel& sentinel) {
+            return it.base() == sentinel.end_;
+        }
+
+        friend std::ranges::range_difference_t<V> operator-(const Sentinel& sentinel, const Iterator& it)
+            requires std::sized_sentinel_for<BaseSentinel, BaseIterator>
+        {
+            return sentinel.end_ - it.base();
+        }
+
+        friend std::ranges::range_difference_t<V> operator-(const Iterator& it, const Sentinel& sentinel)
+            requires std::sized_sentinel_for<BaseSentinel, BaseIterator>
+        {
+            return it.base() - sentinel.end_;
+        }
+
+    private:
+        BaseSentinel end_{};
+    };
+
+    EnumerateView() = default;
+
+    explicit EnumerateView(V base) : base_(std::move(base)) { }
+
+    Iterator begin() {
+        return Iterator(std::ranges::begin(base_), 0);
+    }
+
+    // Common and sized ranges end with a real iterator, so the view stays common
+    auto end() {
+        if constexpr (std::ranges::common_range<V> && std::ranges::sized_range<V>) {
+            return Iterator(std::ranges::end(base_), std::ranges::size(base_));
+        } else {
+            return Sentinel(std::ranges::end(base_));
+        }
+    }
+
+    auto size()
+        requires std::ranges::sized_range<V>
+    {
+        return std::ranges::size(base_);
+    }
+
+    V base() const {
+        return base_;
+    }
+
+private:
+    V base_{};
+};
+
+template <class R>
+EnumerateView(R&&) -> EnumerateView<std::views::all_t<R>>;
+
+namespace detail {
+
+struct EnumerateAdaptor {
+    template <std::ranges::viewable_range R>
+    auto operator()(R&& range) const {
+        return EnumerateView(std::views::all(std::forward<R>(range)));
+    }
+
+    template <std::ranges::viewable_range R>
+    friend auto operator|(R&& range, const EnumerateAdaptor& adaptor) {
+        return adaptor(std::forward<R>(range));
+    }
+};
+
+} // namespace detail
+
+// Enumerate(range) or range | Enumerate
+inline constexpr detail::EnumerateAdaptor Enumerate;
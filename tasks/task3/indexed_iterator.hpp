@@ -1,20 +1,227 @@
+#pragma once
+
+#include <compare>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+
+namespace detail {
+
+// pointer_traits and std::to_address look for element_type, it only makes sense
+// when the wrapped iterator points into contiguous memory
+template <class Iterator, bool = std::contiguous_iterator<Iterator>>
+struct IndexedIteratorElement {
+};
+
+template <class Iterator>
+struct IndexedIteratorElement<Iterator, true> {
+    using element_type = std::remove_reference_t<std::iter_reference_t<Iterator>>;
+};
+
 template <class Iterator>
-class IndexedIterator {
+constexpr auto IteratorConcept() {
+    if constexpr (std::contiguous_iterator<Iterator>) {
+        return std::contiguous_iterator_tag{};
+    } else if constexpr (std::random_access_iterator<Iterator>) {
+        return std::random_access_iterator_tag{};
+    } else if constexpr (std::bidirectional_iterator<Iterator>) {
+        return std::bidirectional_iterator_tag{};
+    } else if constexpr (std::forward_iterator<Iterator>) {
+        return std::forward_iterator_tag{};
+    } else {
+        return std::input_iterator_tag{};
+    }
+}
+
+} // namespace detail
+
+// Index policies of IndexedIterator
+
+// Keeps the index next to the iterator and updates it on every step
+struct EagerIndex {
+    template <class Iterator>
+    class Storage {
+    public:
+        Storage() = default;
+        Storage(const Iterator&, size_t index) : index_(index) { }
+
+        size_t index(const Iterator&) const {
+            return index_;
+        }
+
+        void advance(std::iter_difference_t<Iterator> n) {
+            index_ += n;
+        }
+
+    private:
+        size_t index_ = 0;
+    };
+};
+
+// Remembers the starting iterator and its index, index() computes the distance from it.
+// Steps cost nothing extra, index() is O(1) for random access iterators and linear otherwise.
+// Moving the iterator before its starting point is UB unless it is random access.
+struct LazyIndex {
+    template <class Iterator>
+    class Storage {
+    public:
+        Storage() = default;
+        Storage(const Iterator& origin, size_t index) : origin_(origin), originIndex_(index) { }
+
+        size_t index(const Iterator& it) const {
+            return originIndex_ + std::distance(origin_, it);
+        }
+
+        void advance(std::iter_difference_t<Iterator>) {
+        }
+
+    private:
+        Iterator origin_{};
+        size_t originIndex_ = 0;
+    };
+};
+
+// Wraps 'Iterator' and keeps the index of the current element.
+// Satisfies the same iterator concepts as 'Iterator', up to std::contiguous_iterator.
+template <class Iterator, class IndexPolicy = EagerIndex>
+class IndexedIterator : public detail::IndexedIteratorElement<Iterator> {
 public:
-    // your code goes here
+    using iterator_type = Iterator;
+    using iterator_concept = decltype(detail::IteratorConcept<Iterator>());
+    using iterator_category = typename std::iterator_traits<Iterator>::iterator_category;
+    using value_type = std::iter_value_t<Iterator>;
+    using difference_type = std::iter_difference_t<Iterator>;
+    using pointer = typename std::iterator_traits<Iterator>::pointer;
+    using reference = std::iter_reference_t<Iterator>;
 
-    IndexedIterator(Iterator it, size_t index) {
+    IndexedIterator() = default;
 
-    }
+    IndexedIterator(Iterator it, size_t index) : it_(std::move(it)), index_(it_, index) { }
 
     size_t index() const {
+        return index_.index(it_);
+    }
+
+    const Iterator& base() const {
+        return it_;
+    }
+
+    reference operator*() const {
+        return *it_;
+    }
 
+    auto operator->() const
+        requires std::is_pointer_v<Iterator> || requires(const Iterator& it) { it.operator->(); }
+    {
+        if constexpr (std::is_pointer_v<Iterator>) {
+            return it_;
+        } else {
+            return it_.operator->();
+        }
     }
 
+    reference operator[](difference_type n) const
+        requires std::random_access_iterator<Iterator>
+    {
+        return it_[n];
+    }
+
+    IndexedIterator& operator++() {
+        ++it_;
+        index_.advance(1);
+        return *this;
+    }
+
+    IndexedIterator operator++(int) {
+        IndexedIterator copy = *this;
+        ++*this;
+        return copy;
+    }
+
+    IndexedIterator& operator--()
+        requires std::bidirectional_iterator<Iterator>
+    {
+        --it_;
+        index_.advance(-1);
+        return *this;
+    }
+
+    IndexedIterator operator--(int)
+        requires std::bidirectional_iterator<Iterator>
+    {
+        IndexedIterator copy = *this;
+        --*this;
+        return copy;
+    }
+
+    IndexedIterator& operator+=(difference_type n)
+        requires std::random_access_iterator<Iterator>
+    {
+        it_ += n;
+        index_.advance(n);
+        return *this;
+    }
+
+    IndexedIterator& operator-=(difference_type n)
+        requires std::random_access_iterator<Iterator>
+    {
+        it_ -= n;
+        index_.advance(-n);
+        return *this;
+    }
+
+    friend IndexedIterator operator+(IndexedIterator it, difference_type n)
+        requires std::random_access_iterator<Iterator>
+    {
+        return it += n;
+    }
+
+    friend IndexedIterator operator+(difference_type n, IndexedIterator it)
+        requires std::random_access_iterator<Iterator>
+    {
+        return it += n;
+    }
+
+    friend IndexedIterator operator-(IndexedIterator it, difference_type n)
+        requires std::random_access_iterator<Iterator>
+    {
+        return it -= n;
+    }
+
+    friend difference_type operator-(const IndexedIterator& lhs, const IndexedIterator& rhs)
+        requires std::sized_sentinel_for<Iterator, Iterator>
+    {
+        return lhs.it_ - rhs.it_;
+    }
+
+    // Only base iterators are compared, indices don't matter
+    friend bool operator==(const IndexedIterator& lhs, const IndexedIterator& rhs) {
+        return lhs.it_ == rhs.it_;
+    }
+
+    friend bool operator==(const IndexedIterator& lhs, const Iterator& rhs) {
+        return lhs.it_ == rhs;
+    }
+
+    friend auto operator<=>(const IndexedIterator& lhs, const IndexedIterator& rhs)
+        requires std::random_access_iterator<Iterator> && std::three_way_comparable<Iterator>
+    {
+        return lhs.it_ <=> rhs.it_;
+    }
+
+private:
+    Iterator it_{};
+    typename IndexPolicy::template Storage<Iterator> index_;
 };
 
-template <class It>
-IndexedIterator<It> CreateIndexedIterator(It iterator, size_t index = 0) {
-    return IndexedIterator<It>(iterator, index);
+template <class It, class IndexPolicy = EagerIndex>
+IndexedIterator<It, IndexPolicy> CreateIndexedIterator(It iterator, size_t index = 0) {
+    return IndexedIterator<It, IndexPolicy>(iterator, index);
 }
 
+// The policy as a tag, so it is deduced: CreateIndexedIterator(it, 0, LazyIndex{})
+template <class It, class IndexPolicy>
+IndexedIterator<It, IndexPolicy> CreateIndexedIterator(It iterator, size_t index, IndexPolicy) {
+    return IndexedIterator<It, IndexPolicy>(iterator, index);
+}
@@ -0,0 +1,267 @@
+#pragma once
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define INDEXED_ITERATOR_X86
+#include <immintrin.h>
+#endif
+
+#include "indexed_iterator.hpp"
+
+// MaxElement/MinElement behave like std::max_element/std::min_element on IndexedIterator,
+// the result keeps the correct index(). Contiguous ranges of int, float and double are
+// scanned with SSE2 or AVX2, chosen at runtime, other ranges go to the standard algorithms.
+
+namespace detail {
+
+template <class T>
+concept SimdElement = std::same_as<T, int> || std::same_as<T, float> || std::same_as<T, double>;
+
+template <class Iterator>
+concept SimdIterator = std::contiguous_iterator<Iterator> && SimdElement<std::iter_value_t<Iterator>>;
+
+#ifdef INDEXED_ITERATOR_X86
+
+// Vector operations of one instruction set, every mask is one bit per lane
+
+template <class T>
+struct Sse2Ops;
+
+template <>
+struct Sse2Ops<int> {
+    using Vec = __m128i;
+    static constexpr size_t width = 4;
+
+    static Vec Load(const int* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    static Vec Set(int x) { return _mm_set1_epi32(x); }
+    static void Store(int* p, Vec x) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), x); }
+    // SSE2 has no pmaxsd, select through a comparison
+    static Vec Max(Vec a, Vec b) {
+        const Vec greater = _mm_cmpgt_epi32(b, a);
+        return _mm_or_si128(_mm_and_si128(greater, b), _mm_andnot_si128(greater, a));
+    }
+    static Vec Min(Vec a, Vec b) {
+        const Vec less = _mm_cmplt_epi32(b, a);
+        return _mm_or_si128(_mm_and_si128(less, b), _mm_andnot_si128(less, a));
+    }
+    static int Equal(Vec a, Vec b) { return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(a, b))); }
+    static int Unordered(Vec) { return 0; }
+};
+
+template <>
+struct Sse2Ops<float> {
+    using Vec = __m128;
+    static constexpr size_t width = 4;
+
+    static Vec Load(const float* p) { return _mm_loadu_ps(p); }
+    static Vec Set(float x) { return _mm_set1_ps(x); }
+    static void Store(float* p, Vec x) { _mm_storeu_ps(p, x); }
+    static Vec Max(Vec a, Vec b) { return _mm_max_ps(a, b); }
+    static Vec Min(Vec a, Vec b) { return _mm_min_ps(a, b); }
+    static int Equal(Vec a, Vec b) { return _mm_movemask_ps(_mm_cmpeq_ps(a, b)); }
+    static int Unordered(Vec a) { return _mm_movemask_ps(_mm_cmpunord_ps(a, a)); }
+};
+
+template <>
+struct Sse2Ops<double> {
+    using Vec = __m128d;
+    static constexpr size_t width = 2;
+
+    static Vec Load(const double* p) { return _mm_loadu_pd(p); }
+    static Vec Set(double x) { return _mm_set1_pd(x); }
+    static void Store(double* p, Vec x) { _mm_storeu_pd(p, x); }
+    static Vec Max(Vec a, Vec b) { return _mm_max_pd(a, b); }
+    static Vec Min(Vec a, Vec b) { return _mm_min_pd(a, b); }
+    static int Equal(Vec a, Vec b) { return _mm_movemask_pd(_mm_cmpeq_pd(a, b)); }
+    static int Unordered(Vec a) { return _mm_movemask_pd(_mm_cmpunord_pd(a, a)); }
+};
+
+#define INDEXED_ITERATOR_AVX2 __attribute__((target("avx2")))
+
+template <class T>
+struct Avx2Ops;
+
+template <>
+struct Avx2Ops<int> {
+    using Vec = __m256i;
+    static constexpr size_t width = 8;
+
+    INDEXED_ITERATOR_AVX2 static Vec Load(const int* p) {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    }
+    INDEXED_ITERATOR_AVX2 static Vec Set(int x) { return _mm256_set1_epi32(x); }
+    INDEXED_ITERATOR_AVX2 static void Store(int* p, Vec x) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), x);
+    }
+    INDEXED_ITERATOR_AVX2 static Vec Max(Vec a, Vec b) { return _mm256_max_epi32(a, b); }
+    INDEXED_ITERATOR_AVX2 static Vec Min(Vec a, Vec b) { return _mm256_min_epi32(a, b); }
+    INDEXED_ITERATOR_AVX2 static int Equal(Vec a, Vec b) {
+        return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b)));
+    }
+    INDEXED_ITERATOR_AVX2 static int Unordered(Vec) { return 0; }
+};
+
+template <>
+struct Avx2Ops<float> {
+    using Vec = __m256;
+    static constexpr size_t width = 8;
+
+    INDEXED_ITERATOR_AVX2 static Vec Load(const float* p) { return _mm256_loadu_ps(p); }
+    INDEXED_ITERATOR_AVX2 static Vec Set(float x) { return _mm256_set1_ps(x); }
+    INDEXED_ITERATOR_AVX2 static void Store(float* p, Vec x) { _mm256_storeu_ps(p, x); }
+    INDEXED_ITERATOR_AVX2 static Vec Max(Vec a, Vec b) { return _mm256_max_ps(a, b); }
+    INDEXED_ITERATOR_AVX2 static Vec Min(Vec a, Vec b) { return _mm256_min_ps(a, b); }
+    INDEXED_ITERATOR_AVX2 static int Equal(Vec a, Vec b) {
+        return _mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_EQ_OQ));
+    }
+    INDEXED_ITERATOR_AVX2 static int Unordered(Vec a) {
+        return _mm256_movemask_ps(_mm256_cmp_ps(a, a, _CMP_UNORD_Q));
+    }
+};
+
+template <>
+struct Avx2Ops<double> {
+    using Vec = __m256d;
+    static constexpr size_t width = 4;
+
+    INDEXED_ITERATOR_AVX2 static Vec Load(const double* p) { return _mm256_loadu_pd(p); }
+    INDEXED_ITERATOR_AVX2 static Vec Set(double x) { return _mm256_set1_pd(x); }
+    INDEXED_ITERATOR_AVX2 static void Store(double* p, Vec x) { _mm256_storeu_pd(p, x); }
+    INDEXED_ITERATOR_AVX2 static Vec Max(Vec a, Vec b) { return _mm256_max_pd(a, b); }
+    INDEXED_ITERATOR_AVX2 static Vec Min(Vec a, Vec b) { return _mm256_min_pd(a, b); }
+    INDEXED_ITERATOR_AVX2 static int Equal(Vec a, Vec b) {
+        return _mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_EQ_OQ));
+    }
+    INDEXED_ITERATOR_AVX2 static int Unordered(Vec a) {
+        return _mm256_movemask_pd(_mm256_cmp_pd(a, a, _CMP_UNORD_Q));
+    }
+};
+
+// Returned when the range holds a NaN: comparisons with it make the answer depend on
+// the order of comparisons, so the caller repeats the scan with std::max_element
+constexpr size_t unorderedIndex = static_cast<size_t>(-1);
+
+// The kernel is never called with AVX vectors outside an AVX2 function, GCC warns about
+// the ABI of its uninlined form anyway
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+// Two passes: the extremum value with vector max/min, then the first element equal to it.
+// Both are branch-free inside a vector, so they run at memory speed. The kernel is inlined
+// into the ISA-specific wrappers below, which lets the compiler use their instruction set.
+template <class Ops, bool Max, class T>
+[[gnu::always_inline]] inline size_t ExtremumIndexKernel(const T* data, size_t size) {
+    constexpr size_t width = Ops::width;
+
+    // Two accumulators hide the latency of floating point max/min
+    typename Ops::Vec best[2] = {Ops::Load(data), Ops::Load(data + width)};
+    int unordered = Ops::Unordered(best[0]) | Ops::Unordered(best[1]);
+    size_t i = 2 * width;
+    for (; i + 2 * width <= size; i += 2 * width) {
+        const auto lhs = Ops::Load(data + i);
+        const auto rhs = Ops::Load(data + i + width);
+        best[0] = Max ? Ops::Max(best[0], lhs) : Ops::Min(best[0], lhs);
+        best[1] = Max ? Ops::Max(best[1], rhs) : Ops::Min(best[1], rhs);
+        unordered |= Ops::Unordered(lhs) | Ops::Unordered(rhs);
+    }
+    if (unordered != 0) {
+        return unorderedIndex;
+    }
+
+    T lanes[width];
+    Ops::Store(lanes, Max ? Ops::Max(best[0], best[1]) : Ops::Min(best[0], best[1]));
+    T value = lanes[0];
+    for (size_t lane = 1; lane < width; ++lane) {
+        value = Max ? std::max(value, lanes[lane]) : std::min(value, lanes[lane]);
+    }
+    for (; i < size; ++i) {
+        if (data[i] != data[i]) {
+            return unorderedIndex;
+        }
+        value = Max ? std::max(value, data[i]) : std::min(value, data[i]);
+    }
+
+    const auto needle = Ops::Set(value);
+    for (i = 0; i + width <= size; i += width) {
+        if (const int mask = Ops::Equal(Ops::Load(data + i), needle); mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    while (data[i] != value) {
+        ++i;
+    }
+    return i;
+}
+
+template <bool Max, class T>
+size_t ExtremumIndexSse2(const T* data, size_t size) {
+    return ExtremumIndexKernel<Sse2Ops<T>, Max>(data, size);
+}
+
+template <bool Max, class T>
+INDEXED_ITERATOR_AVX2 size_t ExtremumIndexAvx2(const T* data, size_t size) {
+    return ExtremumIndexKernel<Avx2Ops<T>, Max>(data, size);
+}
+
+#pragma GCC diagnostic pop
+#undef INDEXED_ITERATOR_AVX2
+
+inline bool HasAvx2() {
+    static const bool hasAvx2 = __builtin_cpu_supports("avx2");
+    return hasAvx2;
+}
+
+#endif // INDEXED_ITERATOR_X86
+
+// Offset of the first greatest (Max) or smallest element of a non-empty array
+template <bool Max, class T>
+size_t ExtremumIndex(const T* data, size_t size) {
+#ifdef INDEXED_ITERATOR_X86
+    // Short arrays aren't worth the setup, the kernels also need two full vectors
+    if (size >= 64) {
+        const size_t index = HasAvx2() ? ExtremumIndexAvx2<Max>(data, size) : ExtremumIndexSse2<Max>(data, size);
+        if (index != unorderedIndex) {
+            return index;
+        }
+    }
+#endif
+    return (Max ? std::max_element(data, data + size) : std::min_element(data, data + size)) - data;
+}
+
+} // namespace detail
+
+template <class Iterator, class IndexPolicy>
+IndexedIterator<Iterator, IndexPolicy> MaxElement(IndexedIterator<Iterator, IndexPolicy> first,
+                                                  IndexedIterator<Iterator, IndexPolicy> last) {
+    return std::max_element(first, last);
+}
+
+template <detail::SimdIterator Iterator, class IndexPolicy>
+IndexedIterator<Iterator, IndexPolicy> MaxElement(IndexedIterator<Iterator, IndexPolicy> first,
+                                                  IndexedIterator<Iterator, IndexPolicy> last) {
+    if (first == last) {
+        return last;
+    }
+    return first + detail::ExtremumIndex<true>(std::to_address(first.base()), last - first);
+}
+
+template <class Iterator, class IndexPolicy>
+IndexedIterator<Iterator, IndexPolicy> MinElement(IndexedIterator<Iterator, IndexPolicy> first,
+                                                  IndexedIterator<Iterator, IndexPolicy> last) {
+    return std::min_element(first, last);
+}
+
+template <detail::SimdIterator Iterator, class IndexPolicy>
+IndexedIterator<Iterator, IndexPolicy> MinElement(IndexedIterator<Iterator, IndexPolicy> first,
+                                                  IndexedIterator<Iterator, IndexPolicy> last) {
+    if (first == last) {
+        return last;
+    }
+    return first + detail::ExtremumIndex<false>(std::to_address(first.base()), last - first);
+}
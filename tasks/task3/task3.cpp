@@ -1,13 +1,21 @@
 #include <gtest/gtest.h>
 
 #include <algorithm>
+#include <deque>
 #include <forward_list>
 #include <iterator>
-#include <numeric>
+#include <limits>
 #include <map>
+#include <numeric>
+#include <random>
+#include <ranges>
+#include <stdexcept>
 #include <vector>
 
+#include "algorithms.hpp"
+#include "enumerate.hpp"
 #include "indexed_iterator.hpp"
+#include "min_max.hpp"
 
 TEST(IterateOver, vector) {
     std::vector<int> v { 0, 1, 2, 3, 4, 5 };
@@ -19,6 +27,11 @@ TEST(IterateOver, vector) {
     auto ii_3 = ii + 3;
     ASSERT_EQ(ii_3.index(), 3);
     ASSERT_EQ(ii_3 - ii, 3);
+
+    // The iterator type is the first template parameter, as before index policies
+    auto explicitType = CreateIndexedIterator<std::vector<int>::iterator>(v.begin(), 1);
+    static_assert(std::is_same_v<decltype(explicitType), IndexedIterator<std::vector<int>::iterator>>);
+    ASSERT_EQ(1u, explicitType.index());
 }
 
 TEST(IteratorTraits, find) {
@@ -78,3 +91,221 @@ TEST(IterateOver, stress) {
         ASSERT_EQ(i, iter.index());
     }
 }
+
+TEST(IteratorTraits, randomAccessOperators) {
+    std::vector<int> v { 0, 1, 2, 3, 4, 5 };
+    auto ii = CreateIndexedIterator(v.begin(), 10);
+    auto ii_end = CreateIndexedIterator(v.end(), 16);
+
+    ASSERT_EQ(3, ii[3]);
+    ASSERT_TRUE(ii < ii_end);
+    ASSERT_TRUE(ii_end >= ii + 6);
+
+    auto ii_2 = 2 + ii;
+    ASSERT_EQ(12u, ii_2.index());
+    ASSERT_EQ(11u, (--ii_2).index());
+    ASSERT_EQ(11u, (ii_2--).index());
+    ASSERT_EQ(ii, ii_2);
+
+    ii_end -= 2;
+    ASSERT_EQ(4, *ii_end);
+    ASSERT_EQ(14u, ii_end.index());
+}
+
+TEST(IteratorTraits, ranges) {
+    static_assert(std::contiguous_iterator<IndexedIterator<std::vector<int>::iterator>>);
+    static_assert(std::contiguous_iterator<IndexedIterator<const int*>>);
+    static_assert(std::random_access_iterator<IndexedIterator<std::deque<int>::iterator>>);
+    static_assert(!std::contiguous_iterator<IndexedIterator<std::deque<int>::iterator>>);
+    static_assert(std::bidirectional_iterator<IndexedIterator<std::map<int, int>::iterator>>);
+    static_assert(std::forward_iterator<IndexedIterator<std::forward_list<int>::iterator>>);
+    static_assert(std::sentinel_for<std::vector<int>::iterator, IndexedIterator<std::vector<int>::iterator>>);
+
+    std::vector<int> v { 3, 1, 4, 1, 5, 9, 2, 6 };
+    auto first = CreateIndexedIterator(v.begin());
+    auto last = CreateIndexedIterator(v.end(), v.size());
+    ASSERT_EQ(5u, std::ranges::max_element(first, last).index());
+    ASSERT_EQ(1u, std::ranges::min_element(std::ranges::subrange(first, v.end())).index());
+    ASSERT_EQ(v.data() + 2, std::to_address(first + 2));
+
+    std::vector<int> copy(v.size());
+    std::ranges::copy(first, last, copy.begin());
+    ASSERT_EQ(v, copy);
+}
+
+TEST(LazyIndex, matchesEager) {
+    std::map<int, int> m;
+    for (int i = 0; i < 100; ++i) {
+        m[i] = i;
+    }
+    auto lazy = CreateIndexedIterator(m.begin(), 5, LazyIndex{});
+    for (auto eager = CreateIndexedIterator(m.begin(), 5); eager != m.end(); ++eager, ++lazy) {
+        ASSERT_EQ(eager.index(), lazy.index());
+        ASSERT_EQ(eager->first, lazy->first);
+    }
+    ASSERT_EQ(lazy, m.end());
+    ASSERT_EQ(104u, (--lazy).index());
+
+    std::forward_list<std::string> list {"cpp", "is", "very", "cool", "language"};
+    auto ii = CreateIndexedIterator(list.begin(), 0, LazyIndex{});
+    auto ii_4 = ii;
+    std::advance(ii_4, 4);
+    ASSERT_EQ(4u, ii_4.index());
+    ASSERT_EQ("language", *ii_4);
+
+    std::vector<int> v { 0, 1, 2, 3, 4, 5 };
+    auto vi = CreateIndexedIterator(v.begin() + 2, 2, LazyIndex{});
+    ASSERT_EQ(0u, (vi - 2).index());
+    ASSERT_EQ(5u, std::ranges::max_element(vi, CreateIndexedIterator(v.end(), 6, LazyIndex{})).index());
+    static_assert(std::contiguous_iterator<decltype(vi)>);
+}
+
+TEST(Enumerate, pipelines) {
+    std::vector<int> v { 10, 11, 12, 13, 14, 15 };
+
+    for (auto [i, x] : v | Enumerate) {
+        x -= static_cast<int>(i);
+    }
+    ASSERT_EQ(std::vector<int>(6, 10), v);
+
+    std::vector<size_t> odd;
+    std::vector<int> w { 3, 1, 4, 1, 5, 9, 2, 6 };
+    for (auto [i, x] : w | std::views::take(6) | Enumerate
+                         | std::views::filter([](const auto& p) { return p.second % 2 != 0; })) {
+        odd.push_back(i);
+    }
+    ASSERT_EQ((std::vector<size_t>{0, 1, 3, 4, 5}), odd);
+
+    auto enumerated = Enumerate(w);
+    static_assert(std::ranges::random_access_range<decltype(enumerated)>);
+    static_assert(std::ranges::common_range<decltype(enumerated)>);
+    ASSERT_EQ(8u, enumerated.size());
+    ASSERT_EQ(5u, std::ranges::max_element(enumerated, {}, [](const auto& p) { return p.second; }).index());
+
+    auto reversed = enumerated | std::views::reverse;
+    ASSERT_EQ(7u, (*reversed.begin()).first);
+
+    std::forward_list<std::string> list {"cpp", "is", "cool"};
+    size_t expected = 0;
+    for (const auto& [i, s] : list | Enumerate) {
+        ASSERT_EQ(expected++, i);
+        ASSERT_FALSE(s.empty());
+    }
+    ASSERT_EQ(3u, expected);
+}
+
+TEST(Parallel, argmaxArgmin) {
+    std::vector<int> v(1 << 20);
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> dist(-1000, 1000);
+    for (auto& x : v) {
+        x = dist(gen);
+    }
+    // Equal extremums in different parts, the first one wins
+    v[100] = v[700000] = 5000;
+    v[300000] = v[900000] = -5000;
+
+    for (size_t threads : { 1, 2, 3, 8 }) {
+        ASSERT_EQ(100u, ParallelArgMax(v, std::ranges::less{}, threads));
+        ASSERT_EQ(300000u, ParallelArgMin(v, std::ranges::less{}, threads));
+        ASSERT_EQ(300000u, ParallelFindFirstIndex(v, [](int x) { return x < -1000; }, threads));
+        ASSERT_EQ(v.size(), ParallelFindFirstIndex(v, [](int x) { return x > 5000; }, threads));
+    }
+    ASSERT_EQ(size_t(std::max_element(v.begin(), v.end()) - v.begin()), ParallelArgMax(v));
+
+    std::vector<int> empty;
+    ASSERT_EQ(0u, ParallelArgMax(empty));
+    ASSERT_EQ(0u, ParallelFindFirstIndex(empty, [](int) { return true; }));
+}
+
+template <class R>
+concept ArgMaxable = requires(R range) { ParallelArgMax(range); };
+
+static_assert(ArgMaxable<std::ranges::iota_view<int, int>>);
+static_assert(!ArgMaxable<decltype(std::views::iota(0))>);
+
+TEST(Parallel, exceptions) {
+    std::vector<int> v(1 << 20);
+    std::iota(v.begin(), v.end(), 0);
+    const auto throwing = [](int x) {
+        if (x == 900000) {
+            throw std::runtime_error("bad element");
+        }
+        return false;
+    };
+
+    for (size_t threads : { 1, 2, 3, 8 }) {
+        ASSERT_THROW(ParallelFindFirstIndex(v, throwing, threads), std::runtime_error);
+        ASSERT_THROW(ParallelArgMax(v, [&](int lhs, int rhs) { return throwing(lhs) || lhs < rhs; }, threads),
+                     std::runtime_error);
+    }
+}
+
+template <class T>
+void CheckMinMax(const std::vector<T>& v) {
+    const auto first = CreateIndexedIterator(v.begin());
+    const auto last = CreateIndexedIterator(v.end(), v.size());
+    const auto max = MaxElement(first, last);
+    const auto min = MinElement(first, last);
+    ASSERT_EQ(std::max_element(v.begin(), v.end()), max.base());
+    ASSERT_EQ(std::min_element(v.begin(), v.end()), min.base());
+    ASSERT_EQ(size_t(max.base() - v.begin()), max.index());
+    ASSERT_EQ(size_t(min.base() - v.begin()), min.index());
+}
+
+TEST(MinMax, matchesStd) {
+    std::mt19937 gen(7);
+    for (size_t size : { 0, 1, 5, 63, 64, 65, 100, 1000, 4099 }) {
+        std::vector<int> ints(size);
+        std::vector<float> floats(size);
+        std::vector<double> doubles(size);
+        std::uniform_int_distribution<int> dist(-50, 50);
+        for (size_t i = 0; i < size; ++i) {
+            ints[i] = dist(gen);
+            floats[i] = dist(gen) / 4.0f;
+            doubles[i] = dist(gen) / 8.0;
+        }
+        CheckMinMax(ints);
+        CheckMinMax(floats);
+        CheckMinMax(doubles);
+
+        if (size >= 64) {
+            // Extremum in the scalar tail, then in the first vector
+            ints.back() = 1000;
+            floats.back() = -1000;
+            CheckMinMax(ints);
+            CheckMinMax(floats);
+            ints[1] = 1000;
+            floats[0] = -1000;
+            CheckMinMax(ints);
+            CheckMinMax(floats);
+        }
+    }
+}
+
+TEST(MinMax, special) {
+    std::vector<float> zeros(100, 0.0f);
+    zeros[10] = -0.0f;
+    CheckMinMax(zeros);
+
+    std::vector<double> nan(200, 1.0);
+    nan[50] = 2.0;
+    nan[20] = -1.0;
+    nan[100] = std::numeric_limits<double>::quiet_NaN();
+    CheckMinMax(nan);
+    nan[100] = 0.5;
+    nan[199] = std::numeric_limits<double>::quiet_NaN();
+    CheckMinMax(nan);
+
+    std::vector<int> ints(1000);
+    std::iota(ints.begin(), ints.end(), 0);
+    const auto first = CreateIndexedIterator(ints.begin() + 10, 10, LazyIndex{});
+    const auto last = CreateIndexedIterator(ints.end(), ints.size(), LazyIndex{});
+    ASSERT_EQ(999u, MaxElement(first, last).index());
+    ASSERT_EQ(10u, MinElement(first, last).index());
+
+    // Not SIMD-eligible: the standard algorithms are used
+    std::deque<long> longs(ints.begin(), ints.end());
+    ASSERT_EQ(999u, MaxElement(CreateIndexedIterator(longs.begin()),
+                               CreateIndexedIterator(longs.end(), longs.size())).index());
+}
@@ -1,32 +1,365 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
 // When chunk is free 'next' contains pointer to a next free chunk
 // When it's allocated, this space is used by user
 struct Chunk {
     Chunk* next;
 };
 
+// Snapshot of allocator counters. 'allocations' is the total number of allocate calls,
+// compare two snapshots with AllocationsPerSecond to get the rate.
+struct PoolStats {
+    size_t bytesReserved = 0;
+    size_t bytesLive = 0;
+    size_t blocks = 0;
+    size_t allocations = 0;
+    std::chrono::steady_clock::time_point time;
+};
+
+inline double AllocationsPerSecond(const PoolStats& from, const PoolStats& to) {
+    const std::chrono::duration<double> elapsed = to.time - from.time;
+    return elapsed.count() > 0 ? (to.allocations - from.allocations) / elapsed.count() : 0.0;
+}
+
+// Where PoolAllocator takes its blocks from.
+// HugePages maps blocks with mmap, aligned and rounded up to 2MB, and marks them with
+// MADV_HUGEPAGE so large pools need fewer TLB entries. Falls back to Malloc outside Linux.
+enum class BlockSource {
+    Malloc,
+    HugePages,
+};
+
 class PoolAllocator {
 public:
-    PoolAllocator(size_t chunksPerBlock) : chunksPerBlock_(chunksPerBlock), alloc_(nullptr) { }
+    // If 'maxChunksPerBlock' is greater than 'chunksPerBlock', every new block is twice
+    // as large as the previous one until it reaches 'maxChunksPerBlock'.
+    PoolAllocator(size_t chunksPerBlock, size_t maxChunksPerBlock = 0, BlockSource source = BlockSource::Malloc)
+        : chunksPerBlock_(chunksPerBlock)
+        , maxChunksPerBlock_(std::max(chunksPerBlock, maxChunksPerBlock))
+        , source_(source)
+        , alloc_(nullptr)
+    { }
+
+    PoolAllocator(const PoolAllocator&) = delete;
+    PoolAllocator& operator=(const PoolAllocator&) = delete;
+
+    ~PoolAllocator() {
+        for (const auto& block : blocks_) {
+            freeBlock(block);
+        }
+    }
 
     void* allocate(size_t size) {
         if (alloc_ == nullptr) {
             alloc_ = allocateBlock(size);
         }
-        // your code goes here
+        Chunk* chunk = alloc_;
+        alloc_ = alloc_->next;
+        ++liveChunks_;
+        ++allocations_;
+        return chunk;
     }
 
-    void deallocate(void* chunk, size_t size) {
-        // your code goes here
+    void deallocate(void* chunk, size_t) {
+        auto* freed = reinterpret_cast<Chunk*>(chunk);
+        freed->next = alloc_;
+        alloc_ = freed;
+        --liveChunks_;
+        if (highWaterMark_ != 0 && freeBytes() > trimThreshold_) {
+            trim();
+        }
+    }
+
+    // Takes 'count' chunks at once, they are returned linked through Chunk::next.
+    // The free list keeps no segment lengths, so finding the end of the taken segment walks it:
+    // O(count) in total. Only detaching the segment is O(1), a single head update.
+    Chunk* allocateBatch(size_t size, size_t count) {
+        Chunk* first = nullptr;
+        Chunk** tail = &first;
+        while (count > 0) {
+            if (alloc_ == nullptr) {
+                alloc_ = allocateBlock(size);
+            }
+            Chunk* last = alloc_;
+            size_t taken = 1;
+            while (taken < count && last->next != nullptr) {
+                last = last->next;
+                ++taken;
+            }
+            *tail = alloc_;
+            tail = &last->next;
+            alloc_ = last->next;
+            count -= taken;
+            liveChunks_ += taken;
+            allocations_ += taken;
+        }
+        *tail = nullptr;
+        return first;
+    }
+
+    // Returns 'count' chunks linked from 'first' to 'last' in O(1)
+    void deallocateBatch(Chunk* first, Chunk* last, size_t count) {
+        last->next = alloc_;
+        alloc_ = first;
+        liveChunks_ -= count;
+        if (highWaterMark_ != 0 && freeBytes() > trimThreshold_) {
+            trim();
+        }
+    }
+
+    // Returns blocks without live chunks to the system, returns the number of released bytes.
+    // Occupancy is computed here by walking the free list, so allocate/deallocate stay O(1).
+    size_t trim() {
+        std::sort(blocks_.begin(), blocks_.end(), [](const Block& lhs, const Block& rhs) {
+            return lhs.begin < rhs.begin;
+        });
+
+        std::vector<size_t> freeChunks(blocks_.size());
+        for (Chunk* chunk = alloc_; chunk != nullptr; chunk = chunk->next) {
+            ++freeChunks[findBlock(chunk)];
+        }
+
+        Chunk** link = &alloc_;
+        for (Chunk* chunk = alloc_; chunk != nullptr; chunk = chunk->next) {
+            const size_t block = findBlock(chunk);
+            if (freeChunks[block] != blocks_[block].chunks) {
+                *link = chunk;
+                link = &chunk->next;
+            }
+        }
+        *link = nullptr;
+
+        size_t released = 0;
+        size_t kept = 0;
+        for (size_t i = 0; i < blocks_.size(); ++i) {
+            if (freeChunks[i] == blocks_[i].chunks) {
+                released += blocks_[i].bytes;
+                freeBlock(blocks_[i]);
+            } else {
+                blocks_[kept++] = blocks_[i];
+            }
+        }
+        blocks_.resize(kept);
+        bytesReserved_ -= released;
+
+        // Don't walk the free list again until it doubles, fragmented pools would trim on every call otherwise
+        trimThreshold_ = std::max(highWaterMark_, 2 * freeBytes());
+        return released;
+    }
+
+    // Once free (reserved but not live) memory exceeds 'bytes', deallocate calls trim().
+    // Zero disables automatic trimming.
+    void setHighWaterMark(size_t bytes) {
+        highWaterMark_ = bytes;
+        trimThreshold_ = bytes;
+    }
+
+    PoolStats stats() const {
+        PoolStats stats;
+        stats.bytesReserved = bytesReserved_;
+        stats.bytesLive = liveChunks_ * chunkSize_;
+        stats.blocks = blocks_.size();
+        stats.allocations = allocations_;
+        stats.time = std::chrono::steady_clock::now();
+        return stats;
     }
 
 private:
+    struct Block {
+        char* begin;
+        size_t chunks;
+        size_t bytes;
+    };
+
+    static constexpr size_t hugePageSize = size_t(2) << 20;
+
     size_t chunksPerBlock_;
+    size_t maxChunksPerBlock_;
+    BlockSource source_;
     Chunk* alloc_;
+    size_t chunkSize_ = 0;
+    std::vector<Block> blocks_;
+
+    size_t bytesReserved_ = 0;
+    size_t liveChunks_ = 0;
+    size_t allocations_ = 0;
+    size_t highWaterMark_ = 0;
+    size_t trimThreshold_ = 0;
 
 private:
     Chunk* allocateBlock(size_t chunkSize) {
-        // your code goes here
+        Block block = source_ == BlockSource::HugePages
+                    ? mapBlock(chunkSize, chunksPerBlock_)
+                    : mallocBlock(chunkSize, chunksPerBlock_);
+        blocks_.push_back(block);
+        chunkSize_ = chunkSize;
+        bytesReserved_ += block.bytes;
+        chunksPerBlock_ = std::min(2 * chunksPerBlock_, maxChunksPerBlock_);
+
+        char* begin = block.begin;
+        auto* chunk = reinterpret_cast<Chunk*>(begin);
+        for (size_t i = 1; i < block.chunks; ++i) {
+            chunk->next = reinterpret_cast<Chunk*>(begin + i * chunkSize);
+            chunk = chunk->next;
+        }
+        chunk->next = nullptr;
+
+        return reinterpret_cast<Chunk*>(begin);
+    }
+
+    static Block mallocBlock(size_t chunkSize, size_t chunks) {
+        auto* begin = static_cast<char*>(std::malloc(chunkSize * chunks));
+        if (begin == nullptr) {
+            throw std::bad_alloc();
+        }
+        return {begin, chunks, chunkSize * chunks};
+    }
+
+    // The whole mapping is split into chunks, so the block may hold more than 'chunks'
+    static Block mapBlock(size_t chunkSize, size_t chunks) {
+#ifdef __linux__
+        const size_t bytes = (chunkSize * chunks + hugePageSize - 1) / hugePageSize * hugePageSize;
+        // Over-map by one huge page and cut the unaligned ends off
+        void* mapped = mmap(nullptr, bytes + hugePageSize, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mapped == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        auto* raw = static_cast<char*>(mapped);
+        const auto address = reinterpret_cast<uintptr_t>(raw);
+        auto* begin = raw + ((hugePageSize - address % hugePageSize) % hugePageSize);
+        const size_t head = begin - raw;
+        if (head != 0) {
+            munmap(raw, head);
+        }
+        munmap(begin + bytes, hugePageSize - head);
+        madvise(begin, bytes, MADV_HUGEPAGE);
+        return {begin, bytes / chunkSize, bytes};
+#else
+        return mallocBlock(chunkSize, chunks);
+#endif
+    }
+
+    void freeBlock(const Block& block) const {
+#ifdef __linux__
+        if (source_ == BlockSource::HugePages) {
+            munmap(block.begin, block.bytes);
+            return;
+        }
+#endif
+        std::free(block.begin);
+    }
+
+    size_t freeBytes() const {
+        return bytesReserved_ - liveChunks_ * chunkSize_;
+    }
+
+    // blocks_ must be sorted by address
+    size_t findBlock(const Chunk* chunk) const {
+        auto it = std::upper_bound(blocks_.begin(), blocks_.end(), reinterpret_cast<const char*>(chunk),
+                                   [](const char* address, const Block& block) {
+                                       return address < block.begin;
+                                   });
+        return it - blocks_.begin() - 1;
+    }
+};
+
+// Serves objects of different sizes from one instance.
+// Requests are rounded up to a multiple of 'granularity' and served by the PoolAllocator
+// of that size class, requests larger than 'maxSize' go straight to ::operator new.
+// A chunk is aligned to alignof(std::max_align_t) or less as long as the requested size
+// is a multiple of the required alignment, which always holds for sizeof(T).
+class SizeClassPoolAllocator {
+public:
+    static constexpr size_t granularity = 8;
+    static constexpr size_t maxSize = 512;
+    static constexpr size_t classCount = maxSize / granularity;
+
+    SizeClassPoolAllocator(size_t chunksPerBlock, size_t maxChunksPerBlock = 0,
+                           BlockSource source = BlockSource::Malloc)
+        : classes_(makeClasses(chunksPerBlock, maxChunksPerBlock, source))
+    { }
+
+    void* allocate(size_t size) {
+        if (size > maxSize) {
+            return ::operator new(size);
+        }
+        const size_t index = classIndex(size);
+        return classes_[index].allocate(classSize(index));
+    }
+
+    void deallocate(void* chunk, size_t size) {
+        if (size > maxSize) {
+            ::operator delete(chunk, size);
+            return;
+        }
+        const size_t index = classIndex(size);
+        classes_[index].deallocate(chunk, classSize(index));
+    }
+
+    size_t trim() {
+        size_t released = 0;
+        for (auto& sizeClass : classes_) {
+            released += sizeClass.trim();
+        }
+        return released;
+    }
+
+    // The high-water mark applies to every size class separately
+    void setHighWaterMark(size_t bytes) {
+        for (auto& sizeClass : classes_) {
+            sizeClass.setHighWaterMark(bytes);
+        }
+    }
+
+    // Oversized allocations bypass the pool and aren't counted
+    PoolStats stats() const {
+        PoolStats total;
+        for (const auto& sizeClass : classes_) {
+            const PoolStats stats = sizeClass.stats();
+            total.bytesReserved += stats.bytesReserved;
+            total.bytesLive += stats.bytesLive;
+            total.blocks += stats.blocks;
+            total.allocations += stats.allocations;
+        }
+        total.time = std::chrono::steady_clock::now();
+        return total;
+    }
+
+    static constexpr size_t classIndex(size_t size) {
+        return size == 0 ? 0 : (size - 1) / granularity;
+    }
+
+    static constexpr size_t classSize(size_t index) {
+        return (index + 1) * granularity;
+    }
+
+private:
+    std::array<PoolAllocator, classCount> classes_;
+
+private:
+    template <size_t... Is>
+    static std::array<PoolAllocator, classCount> makeClasses(size_t chunksPerBlock, size_t maxChunksPerBlock,
+                                                             BlockSource source, std::index_sequence<Is...>) {
+        return {{ (static_cast<void>(Is), PoolAllocator(chunksPerBlock, maxChunksPerBlock, source))... }};
+    }
+
+    static std::array<PoolAllocator, classCount> makeClasses(size_t chunksPerBlock, size_t maxChunksPerBlock,
+                                                             BlockSource source) {
+        return makeClasses(chunksPerBlock, maxChunksPerBlock, source, std::make_index_sequence<classCount>());
     }
 };
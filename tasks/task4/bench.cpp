@@ -0,0 +1,142 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <list>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <random>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include "pool_resource.hpp"
+
+namespace {
+
+constexpr size_t chunksPerBlock = 1024;
+
+template <class F>
+double Measure(F&& f) {
+    const auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Nodes of several sizes are created and freed in waves, as in a long-running service.
+void ListChurn(std::pmr::memory_resource* resource) {
+    constexpr int waves = 100;
+    constexpr int nodes = 10000;
+    std::pmr::list<int> ints(resource);
+    std::pmr::list<std::pair<double, double>> pairs(resource);
+
+    for (int wave = 0; wave < waves; ++wave) {
+        for (int i = 0; i < nodes; ++i) {
+            ints.push_back(i);
+            pairs.emplace_back(i, i);
+        }
+        while (ints.size() > nodes / 10) {
+            ints.pop_front();
+            pairs.pop_back();
+        }
+    }
+}
+
+void Strings(std::pmr::memory_resource* resource) {
+    constexpr int rounds = 100;
+    constexpr int count = 10000;
+    for (int round = 0; round < rounds; ++round) {
+        std::pmr::vector<std::pmr::string> strings(resource);
+        for (int i = 0; i < count; ++i) {
+            strings.emplace_back("a string which is too long for the small buffer");
+        }
+    }
+}
+
+template <class MakeResource>
+void Run(const char* name, MakeResource makeResource) {
+    const double churn = Measure([&] {
+        auto resource = makeResource();
+        ListChurn(resource.get());
+    });
+    const double strings = Measure([&] {
+        auto resource = makeResource();
+        Strings(resource.get());
+    });
+    std::printf("%-32s %10.1f %10.1f\n", name, churn, strings);
+}
+
+long MinorFaults() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_minflt;
+}
+
+struct Payload {
+    uint64_t d[5];
+};
+
+// Allocates a lot of objects, then touches them in random order to expose TLB misses
+void RunPolicy(const char* name, size_t chunksPerBlock, size_t maxChunksPerBlock, BlockSource source) {
+    constexpr size_t count = 1e7;
+    constexpr size_t passes = 3;
+    std::vector<Payload*> objects(count);
+    std::vector<uint32_t> order(count);
+    for (size_t i = 0; i < count; ++i) {
+        order[i] = i;
+    }
+    std::shuffle(order.begin(), order.end(), std::mt19937(42));
+
+    PoolAllocator allocator(chunksPerBlock, maxChunksPerBlock, source);
+    const long faults = MinorFaults();
+    const double allocate = Measure([&] {
+        for (size_t i = 0; i < count; ++i) {
+            objects[i] = static_cast<Payload*>(allocator.allocate(sizeof(Payload)));
+            objects[i]->d[0] = i;
+        }
+    });
+    uint64_t sum = 0;
+    const double touch = Measure([&] {
+        for (size_t pass = 0; pass < passes; ++pass) {
+            for (uint32_t i : order) {
+                sum += objects[i]->d[0];
+            }
+        }
+    });
+    const double deallocate = Measure([&] {
+        for (auto* object : objects) {
+            allocator.deallocate(object, sizeof(Payload));
+        }
+    });
+    std::printf("%-32s %10.1f %10.1f %10.1f %10ld %10zu   (%llu)\n", name, allocate, touch, deallocate,
+                MinorFaults() - faults, allocator.stats().blocks, static_cast<unsigned long long>(sum));
+}
+
+} // namespace
+
+int main() {
+    std::printf("%-32s %10s %10s\n", "resource, ms", "list", "strings");
+    Run("new_delete_resource", [] {
+        struct NewDelete {
+            std::pmr::memory_resource* get() { return std::pmr::new_delete_resource(); }
+        };
+        return NewDelete{};
+    });
+    Run("PoolResource", [] {
+        return std::make_unique<PoolResource>(chunksPerBlock);
+    });
+    Run("unsynchronized_pool_resource", [] {
+        return std::make_unique<std::pmr::unsynchronized_pool_resource>();
+    });
+    // Never reuses freed memory, so it is an upper bound for pure allocation speed
+    Run("monotonic_buffer_resource", [] {
+        return std::make_unique<std::pmr::monotonic_buffer_resource>();
+    });
+
+    std::printf("\n%-32s %10s %10s %10s %10s %10s\n", "block policy, ms", "allocate", "touch", "free",
+                "faults", "blocks");
+    RunPolicy("fixed, 8 chunks", 8, 0, BlockSource::Malloc);
+    RunPolicy("fixed, 1024 chunks", 1024, 0, BlockSource::Malloc);
+    RunPolicy("geometric, 8..64K chunks", 8, 1 << 16, BlockSource::Malloc);
+    RunPolicy("geometric, 8..64K, huge pages", 8, 1 << 16, BlockSource::HugePages);
+}
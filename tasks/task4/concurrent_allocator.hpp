@@ -0,0 +1,260 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "allocator.hpp"
+
+// Thread-safe counterpart of PoolAllocator.
+// Every thread works with its own cache of free chunks, so allocate/deallocate don't touch
+// shared state in the common case. Chunks move between threads in batches of 'batchSize'
+// through the depot: a lock-free stack of batches.
+// Unlike PoolAllocator the chunk size is fixed at construction, since threads may race on
+// the first allocation. Blocks are returned to the system only by the destructor: the depot
+// relies on chunk memory staying mapped while the allocator lives, see popBatch.
+class ConcurrentPoolAllocator {
+public:
+    ConcurrentPoolAllocator(size_t chunkSize, size_t chunksPerBlock, size_t batchSize = 64)
+        : chunkSize_(roundChunkSize(chunkSize))
+        , chunksPerBlock_(chunksPerBlock)
+        , batchSize_(std::max<size_t>(batchSize, 1))
+        , id_(nextId_.fetch_add(1, std::memory_order_relaxed))
+    { }
+
+    ConcurrentPoolAllocator(const ConcurrentPoolAllocator&) = delete;
+    ConcurrentPoolAllocator& operator=(const ConcurrentPoolAllocator&) = delete;
+
+    ~ConcurrentPoolAllocator() {
+        Block* block = blocks_.load(std::memory_order_acquire);
+        while (block != nullptr) {
+            Block* next = block->next;
+            std::free(block);
+            block = next;
+        }
+    }
+
+    void* allocate([[maybe_unused]] size_t size) {
+        assert(size <= chunkSize_);
+        Cache& cache = localCache();
+        if (cache.head == nullptr) {
+            refill(cache);
+        }
+        Chunk* chunk = cache.head;
+        cache.head = chunk->next;
+        --cache.count;
+        return chunk;
+    }
+
+    void deallocate(void* chunk, size_t) {
+        Cache& cache = localCache();
+        auto* freed = reinterpret_cast<Chunk*>(chunk);
+        freed->next = cache.head;
+        cache.head = freed;
+        if (++cache.count >= 2 * batchSize_) {
+            drain(cache);
+        }
+    }
+
+    size_t chunkSize() const {
+        return chunkSize_;
+    }
+
+private:
+    // The first chunk of a batch in the depot. 'next' overlays Chunk::next and links
+    // the rest of the batch, 'nextBatch' links batches in the depot.
+    struct Batch {
+        Chunk* next;
+        std::atomic<Batch*> nextBatch;
+    };
+
+    struct Block {
+        Block* next;
+    };
+
+    struct Cache {
+        Chunk* head = nullptr;
+        size_t count = 0;
+        // False once the owning thread has exited, then another thread may adopt the cache
+        // together with its chunks.
+        std::atomic<bool> owned{true};
+    };
+
+    // Caches of the allocators a thread has used. The entries are weak: the allocator owns
+    // its caches, entries of destroyed allocators expire and are swept on lookup.
+    struct ThreadCaches {
+        std::vector<std::pair<uint64_t, std::weak_ptr<Cache>>> entries;
+        uint64_t lastId = 0;
+        Cache* last = nullptr;
+
+        ~ThreadCaches() {
+            for (auto& entry : entries) {
+                if (auto cache = entry.second.lock()) {
+                    cache->owned.store(false, std::memory_order_release);
+                }
+            }
+        }
+    };
+
+    // The depot top is a Batch pointer packed with a 16-bit version tag to defeat ABA.
+    // User-space addresses fit into the lower 48 bits on x86-64 and AArch64.
+    static constexpr int pointerBits = 48;
+    static constexpr uint64_t pointerMask = (uint64_t(1) << pointerBits) - 1;
+
+    static_assert(sizeof(void*) == 8, "depot tagging requires 64-bit pointers");
+
+    const size_t chunkSize_;
+    const size_t chunksPerBlock_;
+    const size_t batchSize_;
+    const uint64_t id_;
+
+    std::atomic<uint64_t> depot_{0};
+    std::atomic<Block*> blocks_{nullptr};
+
+    std::mutex cachesMutex_;
+    std::vector<std::shared_ptr<Cache>> caches_;
+
+    static inline std::atomic<uint64_t> nextId_{1};
+
+private:
+    static size_t roundChunkSize(size_t size) {
+        constexpr size_t align = alignof(Batch);
+        size = std::max(size, sizeof(Batch));
+        return (size + align - 1) / align * align;
+    }
+
+    static Batch* unpack(uint64_t top) {
+        return reinterpret_cast<Batch*>(top & pointerMask);
+    }
+
+    static uint64_t pack(Batch* batch, uint64_t previous) {
+        const uint64_t tag = (previous >> pointerBits) + 1;
+        return (tag << pointerBits) | reinterpret_cast<uint64_t>(batch);
+    }
+
+    Cache& localCache() {
+        thread_local ThreadCaches threadCaches;
+        if (threadCaches.lastId != id_) {
+            threadCaches.last = findCache(threadCaches);
+            threadCaches.lastId = id_;
+        }
+        return *threadCaches.last;
+    }
+
+    Cache* findCache(ThreadCaches& threadCaches) {
+        Cache* found = nullptr;
+        std::erase_if(threadCaches.entries, [&](const auto& entry) {
+            if (entry.first == id_) {
+                // This allocator is alive and owns the cache, so the entry hasn't expired
+                found = entry.second.lock().get();
+            }
+            return entry.second.expired();
+        });
+        if (found != nullptr) {
+            return found;
+        }
+
+        // Slow path, taken once per thread: adopt a cache of an exited thread or create one.
+        std::shared_ptr<Cache> cache;
+        {
+            std::lock_guard lock(cachesMutex_);
+            for (auto& candidate : caches_) {
+                bool owned = false;
+                if (candidate->owned.compare_exchange_strong(owned, true, std::memory_order_acquire)) {
+                    cache = candidate;
+                    break;
+                }
+            }
+            if (!cache) {
+                cache = std::make_shared<Cache>();
+                caches_.push_back(cache);
+            }
+        }
+        threadCaches.entries.emplace_back(id_, cache);
+        return cache.get();
+    }
+
+    void refill(Cache& cache) {
+        if (Batch* batch = popBatch()) {
+            Chunk* rest = batch->next;
+            batch->~Batch();
+            cache.head = new (batch) Chunk{rest};
+            cache.count = batchSize_;
+        } else {
+            cache.head = allocateBlock();
+            cache.count = chunksPerBlock_;
+        }
+    }
+
+    // Moves the first batchSize_ chunks of the cache to the depot.
+    void drain(Cache& cache) {
+        Chunk* first = cache.head;
+        Chunk* last = first;
+        for (size_t i = 1; i < batchSize_; ++i) {
+            last = last->next;
+        }
+        cache.head = last->next;
+        cache.count -= batchSize_;
+
+        last->next = nullptr;
+        Chunk* rest = first->next;
+        pushBatch(new (first) Batch{rest, nullptr});
+    }
+
+    void pushBatch(Batch* batch) {
+        uint64_t top = depot_.load(std::memory_order_relaxed);
+        do {
+            batch->nextBatch.store(unpack(top), std::memory_order_relaxed);
+        } while (!depot_.compare_exchange_weak(top, pack(batch, top),
+                                               std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    Batch* popBatch() {
+        uint64_t top = depot_.load(std::memory_order_acquire);
+        while (Batch* batch = unpack(top)) {
+            // The known read-after-free of a Treiber stack: another thread may have popped
+            // 'batch' and handed its chunk to a user, who writes into it while nextBatch is read
+            // here. Formally that's a data race, so the value read may be garbage. It is never
+            // used then: the tag changed with the pop and the CAS fails. The read itself can't
+            // fault, blocks stay mapped until the destructor, when no thread uses the depot.
+            Batch* next = batch->nextBatch.load(std::memory_order_relaxed);
+            if (depot_.compare_exchange_weak(top, pack(next, top),
+                                             std::memory_order_acquire, std::memory_order_acquire)) {
+                return batch;
+            }
+        }
+        return nullptr;
+    }
+
+    Chunk* allocateBlock() {
+        constexpr size_t header = (sizeof(Block) + alignof(std::max_align_t) - 1)
+                                  / alignof(std::max_align_t) * alignof(std::max_align_t);
+        auto* memory = static_cast<char*>(std::malloc(header + chunkSize_ * chunksPerBlock_));
+        if (memory == nullptr) {
+            throw std::bad_alloc();
+        }
+
+        auto* block = new (memory) Block{blocks_.load(std::memory_order_relaxed)};
+        while (!blocks_.compare_exchange_weak(block->next, block,
+                                              std::memory_order_release, std::memory_order_relaxed)) {
+        }
+
+        char* begin = memory + header;
+        auto* chunk = reinterpret_cast<Chunk*>(begin);
+        for (size_t i = 1; i < chunksPerBlock_; ++i) {
+            chunk->next = reinterpret_cast<Chunk*>(begin + i * chunkSize_);
+            chunk = chunk->next;
+        }
+        chunk->next = nullptr;
+
+        return reinterpret_cast<Chunk*>(begin);
+    }
+};
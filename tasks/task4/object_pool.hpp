@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <span>
+#include <utility>
+
+#include "allocator.hpp"
+
+// Typed front end for PoolAllocator: constructs and destroys T in pooled chunks.
+// Batch functions move whole chains of chunks between the caller and the free list.
+template <class T>
+class ObjectPool {
+public:
+    static_assert(alignof(T) <= alignof(std::max_align_t), "over-aligned types are not supported");
+
+    static constexpr size_t chunkSize = sizeof(T) < sizeof(Chunk) ? sizeof(Chunk) : sizeof(T);
+
+    class Deleter {
+    public:
+        Deleter(ObjectPool* pool = nullptr) : pool_(pool) { }
+
+        void operator()(T* object) const {
+            pool_->destroy(object);
+        }
+
+    private:
+        ObjectPool* pool_;
+    };
+
+    using UniquePtr = std::unique_ptr<T, Deleter>;
+
+    ObjectPool(size_t chunksPerBlock, size_t maxChunksPerBlock = 0, BlockSource source = BlockSource::Malloc)
+        : allocator_(chunksPerBlock, maxChunksPerBlock, source)
+    { }
+
+    template <class... Args>
+    T* make(Args&&... args) {
+        void* chunk = allocator_.allocate(chunkSize);
+        try {
+            return new (chunk) T(std::forward<Args>(args)...);
+        } catch (...) {
+            allocator_.deallocate(chunk, chunkSize);
+            throw;
+        }
+    }
+
+    void destroy(T* object) {
+        object->~T();
+        allocator_.deallocate(object, chunkSize);
+    }
+
+    template <class... Args>
+    UniquePtr make_unique(Args&&... args) {
+        return UniquePtr(make(std::forward<Args>(args)...), Deleter(this));
+    }
+
+    // Fills 'out' with uninitialized memory for out.size() objects
+    void allocate_n(std::span<T*> out) {
+        if (out.empty()) {
+            return;
+        }
+        Chunk* chunk = allocator_.allocateBatch(chunkSize, out.size());
+        for (auto& object : out) {
+            object = reinterpret_cast<T*>(chunk);
+            chunk = chunk->next;
+        }
+    }
+
+    // Returns memory of already destroyed objects
+    void deallocate_n(std::span<T* const> objects) {
+        if (objects.empty()) {
+            return;
+        }
+        for (size_t i = 0; i + 1 < objects.size(); ++i) {
+            reinterpret_cast<Chunk*>(objects[i])->next = reinterpret_cast<Chunk*>(objects[i + 1]);
+        }
+        allocator_.deallocateBatch(reinterpret_cast<Chunk*>(objects.front()),
+                                   reinterpret_cast<Chunk*>(objects.back()), objects.size());
+    }
+
+    // Constructs out.size() objects from the same arguments.
+    // If a constructor throws, already constructed objects are destroyed and all memory is returned.
+    template <class... Args>
+    void make_n(std::span<T*> out, const Args&... args) {
+        allocate_n(out);
+        size_t constructed = 0;
+        try {
+            for (; constructed < out.size(); ++constructed) {
+                new (out[constructed]) T(args...);
+            }
+        } catch (...) {
+            for (size_t i = 0; i < constructed; ++i) {
+                out[i]->~T();
+            }
+            deallocate_n(out);
+            throw;
+        }
+    }
+
+    void destroy_n(std::span<T* const> objects) {
+        for (T* object : objects) {
+            object->~T();
+        }
+        deallocate_n(objects);
+    }
+
+    PoolStats stats() const {
+        return allocator_.stats();
+    }
+
+private:
+    PoolAllocator allocator_;
+};
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory_resource>
+
+#include "allocator.hpp"
+
+// std::pmr adapter for SizeClassPoolAllocator, so pmr containers can be backed by the pool.
+// Requests that don't fit a size class or need alignment above alignof(std::max_align_t)
+// are forwarded to the upstream resource.
+// Like the allocator itself the resource is not thread-safe. Blocks without live chunks go back
+// to the system on trim() or automatically past the high-water mark, everything else when
+// the resource is destroyed.
+class PoolResource : public std::pmr::memory_resource {
+public:
+    PoolResource(size_t chunksPerBlock,
+                 std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+        : pool_(chunksPerBlock), upstream_(upstream)
+    { }
+
+    PoolResource(const PoolResource&) = delete;
+    PoolResource& operator=(const PoolResource&) = delete;
+
+    std::pmr::memory_resource* upstream_resource() const {
+        return upstream_;
+    }
+
+    size_t trim() {
+        return pool_.trim();
+    }
+
+    void setHighWaterMark(size_t bytes) {
+        pool_.setHighWaterMark(bytes);
+    }
+
+private:
+    SizeClassPoolAllocator pool_;
+    std::pmr::memory_resource* upstream_;
+
+private:
+    // Size classes are multiples of 8 and blocks are aligned to alignof(std::max_align_t),
+    // so rounding the size up to the alignment is enough to get an aligned chunk.
+    static size_t chunkSize(size_t bytes, size_t alignment) {
+        return (std::max<size_t>(bytes, 1) + alignment - 1) / alignment * alignment;
+    }
+
+    static bool fitsPool(size_t size, size_t alignment) {
+        return alignment <= alignof(std::max_align_t) && size <= SizeClassPoolAllocator::maxSize;
+    }
+
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        const size_t size = chunkSize(bytes, alignment);
+        if (!fitsPool(size, alignment)) {
+            return upstream_->allocate(bytes, alignment);
+        }
+        return pool_.allocate(size);
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+        const size_t size = chunkSize(bytes, alignment);
+        if (!fitsPool(size, alignment)) {
+            upstream_->deallocate(p, bytes, alignment);
+            return;
+        }
+        pool_.deallocate(p, size);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
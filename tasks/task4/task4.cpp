@@ -1,8 +1,17 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <list>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <thread>
 #include <vector>
 
 #include "allocator.hpp"
+#include "concurrent_allocator.hpp"
+#include "object_pool.hpp"
+#include "pool_resource.hpp"
 
 struct Object {
     uint64_t d[5];
@@ -35,3 +44,353 @@ TEST(Default, array) {
         }
     }
 }
+
+SizeClassPoolAllocator sharedAllocator{chunksPerBlock};
+
+template <size_t Size>
+struct Sized {
+    char d[Size];
+
+    static void *operator new(size_t size) {
+        return sharedAllocator.allocate(size);
+    }
+
+    static void operator delete(void *ptr, size_t size) {
+        return sharedAllocator.deallocate(ptr, size);
+    }
+};
+
+template <size_t Size>
+void CheckSizeClass() {
+    constexpr size_t count = 100;
+    constexpr size_t stride = SizeClassPoolAllocator::classSize(SizeClassPoolAllocator::classIndex(Size));
+    std::vector<Sized<Size>*> objects;
+
+    for (size_t i = 0; i < count; ++i) {
+        objects.push_back(new Sized<Size>());
+        objects.back()->d[Size - 1] = static_cast<char>(i);
+    }
+
+    for (size_t i = 1; i < count; ++i) {
+        if (i % chunksPerBlock != 0) {
+            ASSERT_EQ(stride, reinterpret_cast<uintptr_t>(objects[i]) - reinterpret_cast<uintptr_t>(objects[i - 1]));
+        }
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        ASSERT_EQ(static_cast<char>(i), objects[i]->d[Size - 1]);
+        delete objects[i];
+    }
+
+    // Freed chunks are reused in LIFO order
+    auto* last = objects.back();
+    auto* reused = new Sized<Size>();
+    ASSERT_EQ(last, reused);
+    delete reused;
+}
+
+TEST(SizeClasses, mixed) {
+    CheckSizeClass<1>();
+    CheckSizeClass<13>();
+    CheckSizeClass<40>();
+    CheckSizeClass<100>();
+    CheckSizeClass<512>();
+}
+
+TEST(SizeClasses, oversized) {
+    auto* big = new Sized<4096>();
+    big->d[4095] = 42;
+    ASSERT_EQ(42, big->d[4095]);
+    delete big;
+}
+
+TEST(Trim, releaseFreeBlocks) {
+    constexpr size_t chunkSize = sizeof(Object);
+    constexpr size_t blocks = 4;
+    PoolAllocator allocator(chunksPerBlock);
+    std::vector<void*> chunks;
+
+    for (size_t i = 0; i < blocks * chunksPerBlock; ++i) {
+        chunks.push_back(allocator.allocate(chunkSize));
+    }
+    auto stats = allocator.stats();
+    ASSERT_EQ(blocks, stats.blocks);
+    ASSERT_EQ(blocks * chunksPerBlock * chunkSize, stats.bytesReserved);
+    ASSERT_EQ(stats.bytesReserved, stats.bytesLive);
+    ASSERT_EQ(blocks * chunksPerBlock, stats.allocations);
+    ASSERT_EQ(0u, allocator.trim());
+
+    // Keep one chunk alive in the second block only
+    void* survivor = chunks[chunksPerBlock + 3];
+    for (void* chunk : chunks) {
+        if (chunk != survivor) {
+            allocator.deallocate(chunk, chunkSize);
+        }
+    }
+    ASSERT_EQ((blocks - 1) * chunksPerBlock * chunkSize, allocator.trim());
+    stats = allocator.stats();
+    ASSERT_EQ(1u, stats.blocks);
+    ASSERT_EQ(chunkSize, stats.bytesLive);
+
+    // The remaining free chunks are still usable
+    for (size_t i = 0; i + 1 < chunksPerBlock; ++i) {
+        allocator.allocate(chunkSize);
+    }
+    ASSERT_EQ(1u, allocator.stats().blocks);
+    allocator.allocate(chunkSize);
+    ASSERT_EQ(2u, allocator.stats().blocks);
+}
+
+TEST(Trim, highWaterMark) {
+    constexpr size_t chunkSize = sizeof(Object);
+    constexpr size_t blocks = 16;
+    PoolAllocator allocator(chunksPerBlock);
+    allocator.setHighWaterMark(2 * chunksPerBlock * chunkSize);
+    std::vector<void*> chunks;
+
+    for (size_t i = 0; i < blocks * chunksPerBlock; ++i) {
+        chunks.push_back(allocator.allocate(chunkSize));
+    }
+    for (void* chunk : chunks) {
+        allocator.deallocate(chunk, chunkSize);
+    }
+
+    const auto stats = allocator.stats();
+    ASSERT_EQ(0u, stats.bytesLive);
+    ASSERT_LE(stats.bytesReserved, 2 * chunksPerBlock * chunkSize);
+}
+
+TEST(Growth, geometric) {
+    constexpr size_t chunkSize = sizeof(Object);
+    constexpr size_t maxChunksPerBlock = 8 * chunksPerBlock;
+    PoolAllocator allocator(chunksPerBlock, maxChunksPerBlock);
+    std::vector<uintptr_t> chunks;
+
+    // Blocks of 8, 16, 32, 64, 64 and 64 chunks
+    constexpr size_t count = 248;
+    for (size_t i = 0; i < count; ++i) {
+        chunks.push_back(reinterpret_cast<uintptr_t>(allocator.allocate(chunkSize)));
+    }
+    ASSERT_EQ(6u, allocator.stats().blocks);
+    ASSERT_EQ(count * chunkSize, allocator.stats().bytesReserved);
+
+    size_t blockBegin = 0;
+    for (size_t blockSize = chunksPerBlock; blockBegin < count; blockSize = std::min(2 * blockSize, maxChunksPerBlock)) {
+        for (size_t i = blockBegin + 1; i < blockBegin + blockSize; ++i) {
+            ASSERT_EQ(chunkSize, chunks[i] - chunks[i - 1]);
+        }
+        blockBegin += blockSize;
+    }
+}
+
+TEST(Growth, hugePages) {
+    constexpr size_t chunkSize = sizeof(Object);
+    constexpr size_t hugePage = size_t(2) << 20;
+    PoolAllocator allocator(chunksPerBlock, 1 << 16, BlockSource::HugePages);
+    std::vector<Object*> objects;
+
+    for (size_t i = 0; i < 100000; ++i) {
+        auto* object = static_cast<Object*>(allocator.allocate(chunkSize));
+        object->d[0] = i;
+        objects.push_back(object);
+    }
+    for (size_t i = 0; i < objects.size(); ++i) {
+        ASSERT_EQ(i, objects[i]->d[0]);
+    }
+
+    const auto stats = allocator.stats();
+    ASSERT_EQ(0u, stats.bytesReserved % hugePage);
+    ASSERT_GE(stats.bytesReserved, objects.size() * chunkSize);
+
+    for (auto* object : objects) {
+        allocator.deallocate(object, chunkSize);
+    }
+    ASSERT_EQ(stats.bytesReserved, allocator.trim());
+    ASSERT_EQ(0u, allocator.stats().blocks);
+}
+
+struct Tracked {
+    static inline int alive = 0;
+    static inline int failAt = -1;
+
+    std::string name;
+    int value;
+
+    Tracked(std::string name, int value) : name(std::move(name)), value(value) {
+        if (alive == failAt) {
+            throw std::runtime_error("constructor failed");
+        }
+        ++alive;
+    }
+
+    ~Tracked() {
+        --alive;
+    }
+};
+
+TEST(ObjectPool, makeDestroy) {
+    ObjectPool<Tracked> pool(chunksPerBlock);
+
+    Tracked* first = pool.make("first", 1);
+    ASSERT_EQ("first", first->name);
+    ASSERT_EQ(1, Tracked::alive);
+    {
+        auto second = pool.make_unique("second", 2);
+        ASSERT_EQ(2, second->value);
+        ASSERT_EQ(2, Tracked::alive);
+    }
+    ASSERT_EQ(1, Tracked::alive);
+    pool.destroy(first);
+    ASSERT_EQ(0, Tracked::alive);
+    ASSERT_EQ(0u, pool.stats().bytesLive);
+
+    Tracked::failAt = 0;
+    ASSERT_THROW(pool.make("fail", 0), std::runtime_error);
+    Tracked::failAt = -1;
+    ASSERT_EQ(0u, pool.stats().bytesLive);
+}
+
+TEST(ObjectPool, batch) {
+    ObjectPool<Tracked> pool(chunksPerBlock);
+    std::vector<Tracked*> objects(1000);
+
+    pool.make_n(objects, "batch", 7);
+    ASSERT_EQ(1000, Tracked::alive);
+    ASSERT_EQ(1000 * ObjectPool<Tracked>::chunkSize, pool.stats().bytesLive);
+    for (auto* object : objects) {
+        ASSERT_EQ(7, object->value);
+    }
+    auto sorted = objects;
+    std::sort(sorted.begin(), sorted.end());
+    ASSERT_EQ(sorted.end(), std::adjacent_find(sorted.begin(), sorted.end()));
+
+    pool.destroy_n(objects);
+    ASSERT_EQ(0, Tracked::alive);
+    ASSERT_EQ(0u, pool.stats().bytesLive);
+
+    // The batch is spliced back in order, so the next batch reuses the same chunks
+    const size_t blocks = pool.stats().blocks;
+    std::vector<Tracked*> again(1000);
+    pool.allocate_n(again);
+    ASSERT_EQ(objects, again);
+    ASSERT_EQ(blocks, pool.stats().blocks);
+    pool.deallocate_n(again);
+
+    Tracked::failAt = 500;
+    ASSERT_THROW(pool.make_n(objects, "batch", 7), std::runtime_error);
+    Tracked::failAt = -1;
+    ASSERT_EQ(0, Tracked::alive);
+    ASSERT_EQ(0u, pool.stats().bytesLive);
+}
+
+TEST(Resource, containers) {
+    PoolResource resource(chunksPerBlock);
+
+    std::pmr::list<int> list(&resource);
+    for (int i = 0; i < 1000; ++i) {
+        list.push_back(i);
+    }
+    ASSERT_EQ(1000u, list.size());
+    ASSERT_EQ(999, list.back());
+
+    std::pmr::vector<std::pmr::string> strings(&resource);
+    for (int i = 0; i < 100; ++i) {
+        strings.emplace_back(std::to_string(i) + " is a string long enough to skip SSO");
+    }
+    ASSERT_EQ(&resource, strings.back().get_allocator().resource());
+    ASSERT_EQ("42 is a string long enough to skip SSO", strings[42]);
+}
+
+TEST(Resource, alignment) {
+    PoolResource resource(chunksPerBlock);
+
+    for (size_t alignment : { 1, 2, 4, 8, 16, 32, 64 }) {
+        for (size_t bytes : { 1, 3, 8, 24, 100, 500, 1000 }) {
+            void* p = resource.allocate(bytes, alignment);
+            ASSERT_EQ(0u, reinterpret_cast<uintptr_t>(p) % alignment);
+            resource.deallocate(p, bytes, alignment);
+        }
+    }
+}
+
+TEST(Resource, trim) {
+    PoolResource resource(chunksPerBlock);
+    {
+        std::pmr::list<int> list(&resource);
+        for (int i = 0; i < 1000; ++i) {
+            list.push_back(i);
+        }
+    }
+    ASSERT_GT(resource.trim(), 0u);
+    ASSERT_EQ(0u, resource.trim());
+}
+
+TEST(Concurrent, stress) {
+    constexpr size_t rounds = 50;
+    constexpr size_t live = 64;
+
+    for (size_t threads : { 1, 2, 4, 8, 16, 32, 64 }) {
+        ConcurrentPoolAllocator allocator(sizeof(Object), chunksPerBlock, 16);
+        // Every thread frees the chunks allocated by its neighbour on the previous round,
+        // so chunks keep migrating between thread caches through the depot.
+        std::vector<std::vector<uint64_t*>> incoming(threads);
+        std::vector<std::vector<uint64_t*>> outgoing(threads);
+        std::vector<std::thread> workers;
+        std::atomic<size_t> errors{0};
+
+        for (size_t round = 0; round < rounds; ++round) {
+            workers.clear();
+            for (size_t t = 0; t < threads; ++t) {
+                workers.emplace_back([&, t] {
+                    for (auto* ptr : incoming[t]) {
+                        if (*ptr != round - 1) {
+                            ++errors;
+                        }
+                        allocator.deallocate(ptr, sizeof(Object));
+                    }
+
+                    std::vector<uint64_t*> mine;
+                    for (size_t i = 0; i < live; ++i) {
+                        auto* ptr = static_cast<uint64_t*>(allocator.allocate(sizeof(Object)));
+                        *ptr = round;
+                        mine.push_back(ptr);
+                    }
+                    outgoing[(t + 1) % threads] = std::move(mine);
+                });
+            }
+            for (auto& worker : workers) {
+                worker.join();
+            }
+            incoming.swap(outgoing);
+
+            std::vector<uint64_t*> all;
+            for (const auto& ptrs : incoming) {
+                all.insert(all.end(), ptrs.begin(), ptrs.end());
+            }
+            std::sort(all.begin(), all.end());
+            ASSERT_EQ(all.end(), std::adjacent_find(all.begin(), all.end()));
+        }
+
+        for (const auto& ptrs : incoming) {
+            for (auto* ptr : ptrs) {
+                allocator.deallocate(ptr, sizeof(Object));
+            }
+        }
+        ASSERT_EQ(errors.load(), 0);
+    }
+}
+
+TEST(Concurrent, shortLivedAllocators) {
+    ConcurrentPoolAllocator longLived(sizeof(Object), chunksPerBlock);
+    void* kept = longLived.allocate(sizeof(Object));
+    for (int i = 0; i < 1000; ++i) {
+        ConcurrentPoolAllocator allocator(sizeof(Object), chunksPerBlock);
+        void* p = allocator.allocate(sizeof(Object));
+        allocator.deallocate(p, sizeof(Object));
+        // Switching back sweeps the cache entry of the previous, destroyed allocator
+        void* q = longLived.allocate(sizeof(Object));
+        ASSERT_NE(kept, q);
+        longLived.deallocate(q, sizeof(Object));
+    }
+    longLived.deallocate(kept, sizeof(Object));
+}